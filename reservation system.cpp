@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <set>
 #include <memory>
 #include <stdexcept>
 #include <limits>
@@ -9,11 +10,52 @@
 #include <fstream>
 #include <climits>
 #include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include <atomic>
+#include <exception>
+#include <ctime>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define RESERVATION_HEAP_STATS 1
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define RESERVATION_SSE42_CRC 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+#ifdef HAVE_SQLITE3  // build with -DHAVE_SQLITE3 -lsqlite3 for the sqlite storage backend
+#include <sqlite3.h>
+#endif
 using namespace std;
 
 const string CURRENT_DATE = "2025-05-22";
 const int CURRENT_HOUR = 22;
 const int CURRENT_MINUTE = 19;
+const int TABLE_COUNT = 10;
 
 // -------- Helper Function for Case-Insensitive Handling --------
 string toUpperCase(const string& str) {
@@ -31,8 +73,10 @@ public:
 };
 
 // -------- Reservation Struct --------
+// Users, logs and files see IDs as "ID <n>A"; everything else holds n. The text
+// form is parsed and formatted only where it enters or leaves the program.
 struct Reservation {
-    string id;
+    long long id;  // -1 for a legacy record whose ID is not of the "ID <n>A" form
     string customerName;
     string phoneNumber;
     int partySize;
@@ -40,18 +84,103 @@ struct Reservation {
     string time;
     int tableNumber;
 
-    Reservation(const string& id, const string& name, const string& phone, int size, const string& date, const string& time, int table)
-        : id(toUpperCase(id)), customerName(name), phoneNumber(phone), partySize(size), date(date), time(time), tableNumber(table) {}
+    Reservation(long long id, const string& name, const string& phone, int size, const string& date, const string& time, int table)
+        : id(id), customerName(name), phoneNumber(phone), partySize(size), date(date), time(time), tableNumber(table) {}
 };
 
+// Accepts "ID <n>A" in any letter case.
+bool parseReservationId(string_view text, long long& id) {
+    if (text.size() < 5 || toupper(text[0]) != 'I' || toupper(text[1]) != 'D' || text[2] != ' ' ||
+        toupper(text.back()) != 'A') {
+        return false;
+    }
+    const char* first = text.data() + 3;
+    const char* last = text.data() + text.size() - 1;
+    long long value;
+    if (!all_of(first, last, ::isdigit)) {
+        return false;
+    }
+    auto parsed = from_chars(first, last, value);
+    if (parsed.ec != errc() || parsed.ptr != last) {
+        return false;
+    }
+    id = value;
+    return true;
+}
+
+// -1 when text is not a reservation ID.
+long long parseReservationIdOrInvalid(string_view text) {
+    long long id;
+    return parseReservationId(text, id) ? id : -1;
+}
+
+// A legacy record without a valid ID is shown, and written back, as "N/A".
+void appendReservationId(string& out, long long id) {
+    if (id < 0) {
+        out.append("N/A", 3);
+        return;
+    }
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), id).ptr;
+    out.append("ID ", 3).append(digits, static_cast<size_t>(end - digits)).append(1, 'A');
+}
+
+string formatReservationId(long long id) {
+    string text;
+    appendReservationId(text, id);
+    return text;
+}
+
+// Length of formatReservationId(id).
+size_t reservationIdLength(long long id) {
+    if (id < 0) {
+        return 3;
+    }
+    size_t length = 5;  // "ID ", one digit and "A"
+    for (long long rest = id; rest >= 10; rest /= 10) {
+        length++;
+    }
+    return length;
+}
+
 // -------- Validation Functions --------
+// Packs "XXX-XXX-XXXX" into the integer XXXXXXXXXX; false for anything else.
+bool packPhoneNumber(string_view phone, uint64_t& key) {
+    if (phone.size() != 12 || phone[3] != '-' || phone[7] != '-') {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < phone.size(); ++i) {
+        if (i == 3 || i == 7) continue;
+        if (phone[i] < '0' || phone[i] > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(phone[i] - '0');
+    }
+    key = value;
+    return true;
+}
+
+// Key of a legacy phone that is not of the XXX-XXX-XXXX form; no packed phone gets it.
+const uint64_t UNPACKED_PHONE = UINT64_MAX;
+
+uint64_t phoneKey(string_view phone) {
+    uint64_t key;
+    return packPhoneNumber(phone, key) ? key : UNPACKED_PHONE;
+}
+
 bool validatePhoneNumber(const string& phone) {
-    regex phoneRegex("\\d{3}-\\d{3}-\\d{4}");
-    return regex_match(phone, phoneRegex);
+    uint64_t key;
+    return packPhoneNumber(phone, key);
+}
+
+// Names are stored in '|'-separated journal records and one-per-line account logs.
+bool validateCustomerName(const string& name) {
+    return !name.empty() && name.find_first_of("|\r\n") == string::npos;
 }
 
+const string INVALID_NAME_MESSAGE = "Customer name must be non-empty and may not contain '|' or line breaks.";
+
 bool validateDate(const string& date) {
-    regex dateRegex("\\d{4}-\\d{2}-\\d{2}");
+    static const regex dateRegex("\\d{4}-\\d{2}-\\d{2}");
     if (!regex_match(date, dateRegex)) {
         return false;
     }
@@ -68,7 +197,7 @@ bool validateDate(const string& date) {
 }
 
 bool validateTime(const string& time, const string& date) {
-    regex timeRegex("\\d{2}:\\d{2}");
+    static const regex timeRegex("\\d{2}:\\d{2}");
     if (!regex_match(time, timeRegex)) {
         return false;
     }
@@ -90,9 +219,8 @@ bool validatePartySize(int size) {
 }
 
 bool validateReservationId(const string& id) {
-    string upperId = toUpperCase(id);
-    regex idRegex("ID \\d+A");
-    return regex_match(upperId, idRegex);
+    long long number;
+    return parseReservationId(id, number);
 }
 
 bool validateNumericInput(const string& input, int& result, int minVal, int maxVal) {
@@ -114,112 +242,4517 @@ bool validateNumericInput(const string& input, int& result, int minVal, int maxV
     }
 }
 
-// -------- Singleton Pattern --------
-class ReservationManager {
-private:
-    vector<bool> tables;
-    vector<Reservation> reservations;
-    static unique_ptr<ReservationManager> instance;
-    int nextReservationId;
+// -------- Date Helpers --------
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm).
+long long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const long long era = (year >= 0 ? year : year - 399) / 400;
+    const long long yearOfEra = year - era * 400;
+    const long long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
 
-    ReservationManager() : tables(10, true), nextReservationId(1) {
-        loadReservations();
+string civilFromDays(long long days) {
+    days += 719468;
+    const long long era = (days >= 0 ? days : days - 146096) / 146097;
+    const long long dayOfEra = days - era * 146097;
+    const long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const long long shiftedMonth = (5 * dayOfYear + 2) / 153;
+    const long long day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    const long long month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    const long long year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%04lld-%02lld-%02lld", year, month, day);
+    return buffer;
+}
+
+// True for the YYYY-MM-DD shape, without range checks.
+bool isDateShaped(const string& date) {
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') return false;
+    for (size_t i = 0; i < date.size(); ++i) {
+        if (i != 4 && i != 7 && !isdigit(static_cast<unsigned char>(date[i]))) return false;
     }
+    return true;
+}
 
-    string getCurrentTimestamp() {
-        ostringstream oss;
-        oss << CURRENT_DATE << " " << (CURRENT_HOUR < 10 ? "0" : "") << CURRENT_HOUR << ":"
-            << (CURRENT_MINUTE < 10 ? "0" : "") << CURRENT_MINUTE << ":00";
-        return oss.str();
+string addDays(const string& date, int days) {
+    int year, month, day;
+    sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day);
+    return civilFromDays(daysFromCivil(year, month, day) + days);
+}
+
+// A reservation's (date, time) as one integer that sorts the same way: days since
+// 1970-01-01 times 1440 plus the minute of the day. Every date up to 9999-12-31 fits
+// in 32 bits. A legacy time that does not parse sorts last in its day; UNTIMED
+// stands for a legacy date that does not.
+const uint32_t UNTIMED = UINT32_MAX;
+
+uint32_t packReservationTime(const string& date, const string& time) {
+    int year, month, day, hour, minute;
+    if (!isDateShaped(date) || sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day) != 3 || month < 1 ||
+        month > 12 || day < 1 || day > 31) {
+        return UNTIMED;
+    }
+    long long days = daysFromCivil(year, month, day);
+    if (days < 0) {
+        return UNTIMED;
     }
+    if (sscanf(time.c_str(), "%d:%d", &hour, &minute) != 2 || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        hour = 23;
+        minute = 59;
+    }
+    return static_cast<uint32_t>(days * 1440 + hour * 60 + minute);
+}
 
-    void writeLogToFile(const string& logEntry) {
-        ofstream logFile("logs.txt", ios::app);
-        if (logFile.is_open()) {
-            logFile << logEntry << "\n\n";
-            logFile.close();
-        } else {
-            throw ReservationException("Unable to open log file.");
+// -------- Storage Configuration --------
+// Tuned per deployment through environment variables; defaults suit a single host.
+enum class DurabilityMode {
+    SyncEveryOp,  // each mutation returns once its journal record is fsynced
+    GroupCommit,  // mutations wait for a shared fsync every few ms or ops
+    Async         // mutations return once queued; the I/O thread fsyncs in the background
+};
+
+// Where reservations are kept; see "Storage Engines". Only the journal backend has
+// segments, archiving, restore history, followers and backups.
+enum class StorageBackend {
+    Journal,         // date segments + write-ahead journal
+    Memory,          // nothing is persisted
+    LegacyText,      // reservations.txt rewritten on every change
+    BinarySnapshot,  // reservations.bin rewritten on every change
+    Sqlite           // SQLite database in WAL mode (HAVE_SQLITE3 builds only)
+};
+
+struct StorageConfig {
+    int checkpointIntervalSeconds = 60;          // RESERVATION_CHECKPOINT_INTERVAL
+    long long checkpointJournalBytes = 1 << 20;  // RESERVATION_CHECKPOINT_BYTES
+    DurabilityMode durability = DurabilityMode::Async;  // RESERVATION_DURABILITY
+    int groupCommitMillis = 5;                   // RESERVATION_GROUP_COMMIT_MS
+    int groupCommitOps = 64;                     // RESERVATION_GROUP_COMMIT_OPS
+    int persistenceQueueCapacity = 4096;         // RESERVATION_QUEUE_CAPACITY
+    int activeWindowDays = 7;                    // RESERVATION_ACTIVE_WINDOW_DAYS
+    int segmentIdleSeconds = 300;                // RESERVATION_SEGMENT_IDLE_SECONDS
+    long long compactionBytesPerSecond = 8 << 20;  // RESERVATION_COMPACTION_BYTES_PER_SEC, 0 = unlimited
+    int archiveHorizonDays = 30;                 // RESERVATION_ARCHIVE_HORIZON_DAYS
+    int restoreHistory = 1440;                   // RESERVATION_RESTORE_HISTORY, checkpoints kept; 0 = none
+    bool follower = false;                       // --follower: read-only replica of another process
+    int followerPollMillis = 50;                 // RESERVATION_FOLLOWER_POLL_MS
+    StorageBackend backend = StorageBackend::Journal;  // RESERVATION_STORAGE_BACKEND
+};
+
+StorageConfig storageConfig;
+
+string durabilityModeName(DurabilityMode mode) {
+    switch (mode) {
+        case DurabilityMode::SyncEveryOp: return "sync-every-op";
+        case DurabilityMode::GroupCommit: return "group-commit";
+        case DurabilityMode::Async: return "async";
+    }
+    return "unknown";
+}
+
+bool parseDurabilityMode(const string& name, DurabilityMode& mode) {
+    if (name == "sync-every-op") {
+        mode = DurabilityMode::SyncEveryOp;
+    } else if (name == "group-commit") {
+        mode = DurabilityMode::GroupCommit;
+    } else if (name == "async") {
+        mode = DurabilityMode::Async;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string storageBackendName(StorageBackend backend) {
+    switch (backend) {
+        case StorageBackend::Journal: return "journal";
+        case StorageBackend::Memory: return "memory";
+        case StorageBackend::LegacyText: return "text";
+        case StorageBackend::BinarySnapshot: return "binary";
+        case StorageBackend::Sqlite: return "sqlite";
+    }
+    return "unknown";
+}
+
+// Backends this build can open, in the order they are listed to users.
+vector<StorageBackend> availableStorageBackends() {
+    vector<StorageBackend> backends = {StorageBackend::Journal, StorageBackend::Memory, StorageBackend::LegacyText,
+                                       StorageBackend::BinarySnapshot};
+#ifdef HAVE_SQLITE3
+    backends.push_back(StorageBackend::Sqlite);
+#endif
+    return backends;
+}
+
+bool parseStorageBackend(const string& name, StorageBackend& backend) {
+    for (StorageBackend candidate : availableStorageBackends()) {
+        if (storageBackendName(candidate) == name) {
+            backend = candidate;
+            return true;
         }
     }
+    return false;
+}
 
-    void saveReservations() {
-        ofstream resFile("reservations.txt");
-        if (!resFile.is_open()) {
-            throw ReservationException("Unable to open reservations file for writing.");
+void loadStorageConfig(StorageConfig& config) {
+    if (const char* value = getenv("RESERVATION_CHECKPOINT_INTERVAL")) {
+        int seconds;
+        if (validateNumericInput(value, seconds, 1, INT_MAX)) {
+            config.checkpointIntervalSeconds = seconds;
         }
-        for (const auto& res : reservations) {
-            resFile << res.id << "|" << res.customerName << "|" << res.phoneNumber << "|"
-                    << res.partySize << "|" << res.date << "|" << res.time << "|"
-                    << res.tableNumber << "\n";
+    }
+    if (const char* value = getenv("RESERVATION_CHECKPOINT_BYTES")) {
+        int bytes;
+        if (validateNumericInput(value, bytes, 1, INT_MAX)) {
+            config.checkpointJournalBytes = bytes;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_DURABILITY")) {
+        if (!parseDurabilityMode(value, config.durability)) {
+            cerr << "Error: Unknown RESERVATION_DURABILITY '" << value
+                 << "'. Use sync-every-op, group-commit or async." << endl;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_STORAGE_BACKEND")) {
+        if (!parseStorageBackend(value, config.backend)) {
+            string names;
+            for (StorageBackend backend : availableStorageBackends()) {
+                names += (names.empty() ? "" : ", ") + storageBackendName(backend);
+            }
+            cerr << "Error: Unknown RESERVATION_STORAGE_BACKEND '" << value << "'. Use " << names << "." << endl;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_GROUP_COMMIT_MS")) {
+        int millis;
+        if (validateNumericInput(value, millis, 1, INT_MAX)) {
+            config.groupCommitMillis = millis;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_GROUP_COMMIT_OPS")) {
+        int ops;
+        if (validateNumericInput(value, ops, 1, INT_MAX)) {
+            config.groupCommitOps = ops;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_QUEUE_CAPACITY")) {
+        int records;
+        if (validateNumericInput(value, records, 1, INT_MAX)) {
+            config.persistenceQueueCapacity = records;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_ACTIVE_WINDOW_DAYS")) {
+        int days;
+        if (validateNumericInput(value, days, 0, 36500)) {
+            config.activeWindowDays = days;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_SEGMENT_IDLE_SECONDS")) {
+        int seconds;
+        if (validateNumericInput(value, seconds, 0, INT_MAX)) {
+            config.segmentIdleSeconds = seconds;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_COMPACTION_BYTES_PER_SEC")) {
+        int bytes;
+        if (validateNumericInput(value, bytes, 0, INT_MAX)) {
+            config.compactionBytesPerSecond = bytes;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_ARCHIVE_HORIZON_DAYS")) {
+        int days;
+        if (validateNumericInput(value, days, 0, 36500)) {
+            config.archiveHorizonDays = days;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_FOLLOWER_POLL_MS")) {
+        int millis;
+        if (validateNumericInput(value, millis, 1, INT_MAX)) {
+            config.followerPollMillis = millis;
+        }
+    }
+    if (const char* value = getenv("RESERVATION_RESTORE_HISTORY")) {
+        int checkpoints;
+        if (validateNumericInput(value, checkpoints, 0, INT_MAX)) {
+            config.restoreHistory = checkpoints;
+        }
+    }
+}
+
+// -------- Durable File Helpers --------
+bool syncDescriptor(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#elif defined(__linux__)
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+int openAppendDescriptor(const string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, 0644);
+#else
+    return open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+}
+
+bool writeDescriptor(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, static_cast<unsigned>(min<size_t>(size, INT_MAX)));
+#else
+        ssize_t written = write(fd, data, size);
+#endif
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void closeDescriptor(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+// Flushes a closed file's contents to stable storage.
+bool syncFile(const string& path) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+#endif
+    if (fd < 0) return false;
+    bool ok = syncDescriptor(fd);
+    closeDescriptor(fd);
+    return ok;
+}
+
+// Makes a rename inside dir durable. Windows has no equivalent.
+void syncDirectory(const string& dir) {
+#ifndef _WIN32
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+// Publishes a fully written temp file under its final name. Readers see either the
+// old file or the new one, never a partial write.
+void commitFile(const string& tempPath, const string& path) {
+    if (!syncFile(tempPath)) {
+        throw ReservationException("Unable to sync " + tempPath + ".");
+    }
+    error_code ec;
+    filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        throw ReservationException("Unable to replace " + path + ".");
+    }
+    string dir = filesystem::path(path).parent_path().string();
+    syncDirectory(dir.empty() ? "." : dir);
+}
+
+void writeFileAtomically(const string& path, const string& contents) {
+    const string temp = path + ".tmp";
+    ofstream file(temp, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw ReservationException("Unable to open " + path + " for writing.");
+    }
+    file << contents;
+    file.close();
+    if (!file) {
+        throw ReservationException("Unable to write " + path + ".");
+    }
+    commitFile(temp, path);
+}
+
+// Paces background writers to an average of bytesPerSecond so compaction does not
+// starve the journal of disk bandwidth. A limit of 0 disables pacing.
+class IoThrottle {
+    long long bytesPerSecond;
+    long long bytesSinceStart;
+    chrono::steady_clock::time_point start;
+public:
+    explicit IoThrottle(long long limit)
+        : bytesPerSecond(limit), bytesSinceStart(0), start(chrono::steady_clock::now()) {}
+
+    void consume(long long bytes) {
+        if (bytesPerSecond <= 0) {
+            return;
         }
-        resFile.close();
+        bytesSinceStart += bytes;
+        auto due = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                               chrono::duration<double>(static_cast<double>(bytesSinceStart) / bytesPerSecond));
+        this_thread::sleep_until(due);
+    }
+};
+
+long long fileBytes(const string& path) {
+    error_code ec;
+    uintmax_t size = filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<long long>(size);
+}
+
+// -------- Parallel Helpers --------
+unsigned workerCount() {
+    unsigned count = thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
 
-        ofstream idFile("next_id.txt");
-        if (!idFile.is_open()) {
-            throw ReservationException("Unable to open next_id file for writing.");
+// Runs task(i) for every i in [0, taskCount) on a pool of up to workerCount()
+// threads. The first exception thrown by a task is rethrown on the caller.
+template <typename Task>
+void runParallel(size_t taskCount, Task task) {
+    size_t threadCount = min<size_t>(workerCount(), taskCount);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < taskCount; ++i) {
+            task(i);
         }
-        idFile << nextReservationId << "\n";
-        idFile.close();
+        return;
+    }
+    atomic<size_t> nextTask(0);
+    exception_ptr failure;
+    mutex failureMutex;
+    auto worker = [&]() {
+        for (size_t i = nextTask++; i < taskCount; i = nextTask++) {
+            try {
+                task(i);
+            } catch (...) {
+                lock_guard<mutex> lock(failureMutex);
+                if (!failure) failure = current_exception();
+            }
+        }
+    };
+    vector<thread> pool;
+    for (size_t t = 1; t < threadCount; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+    if (failure) {
+        rethrow_exception(failure);
     }
+}
 
-    void loadReservations() {
-        ifstream resFile("reservations.txt");
-        if (resFile.is_open()) {
-            string line;
-            while (getline(resFile, line)) {
-                stringstream ss(line);
-                string id, customerName, phoneNumber, date, time;
-                int partySize, tableNumber;
-                getline(ss, id, '|');
-                getline(ss, customerName, '|');
-                getline(ss, phoneNumber, '|');
-                ss >> partySize;
-                ss.ignore(1);
-                getline(ss, date, '|');
-                getline(ss, time, '|');
-                ss >> tableNumber;
-
-                if (tableNumber >= 0 && tableNumber < tables.size()) {
-                    tables[tableNumber] = false;
-                }
+// -------- Zero-Copy Field Parsing --------
+template <typename Int>
+bool parseInteger(string_view text, Int& value) {
+    if (text.empty()) return false;
+    auto result = from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == errc() && result.ptr == text.data() + text.size();
+}
 
-                reservations.emplace_back(id, customerName, phoneNumber, partySize, date, time, tableNumber);
+// Splits a line into exactly fieldCount views; false if the count does not match.
+bool splitFieldViews(string_view line, char delim, string_view* fields, size_t fieldCount) {
+    size_t start = 0;
+    for (size_t i = 0; i + 1 < fieldCount; ++i) {
+        size_t end = line.find(delim, start);
+        if (end == string_view::npos) return false;
+        fields[i] = line.substr(start, end - start);
+        start = end + 1;
+    }
+    fields[fieldCount - 1] = line.substr(start);
+    return fields[fieldCount - 1].find(delim) == string_view::npos;
+}
 
-                // Extract numeric part of ID (e.g., "1" from "ID 1A")
-                if (validateReservationId(id)) {
-                    string numStr = id.substr(3, id.length() - 4);
-                    try {
-                        int idNum = stoi(numStr);
-                        nextReservationId = max(nextReservationId, idNum + 1);
-                    } catch (...) {
-                        // Skip invalid IDs
-                    }
-                }
+// -------- Legacy Text Loader --------
+// Reads the pipe-delimited reservations.txt written by older versions. The file is
+// mapped, cut into newline-aligned chunks, and each chunk is parsed on its own
+// worker straight from the mapping; only the final Reservation copies the bytes.
+bool parseLegacyReservationLine(string_view line, vector<Reservation>& out) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    string_view fields[7];
+    int partySize, tableNumber;
+    if (!splitFieldViews(line, '|', fields, 7) || !parseInteger(fields[3], partySize) ||
+        !parseInteger(fields[6], tableNumber)) {
+        return false;
+    }
+    out.emplace_back(parseReservationIdOrInvalid(fields[0]), string(fields[1]), string(fields[2]), partySize,
+                     string(fields[4]), string(fields[5]), tableNumber);
+    return true;
+}
+
+vector<Reservation> parseLegacyReservations(const char* data, size_t size) {
+    const size_t minChunkBytes = 1 << 20;
+    size_t chunkCount = max<size_t>(1, min<size_t>(workerCount() * 4, size / minChunkBytes));
+    vector<size_t> bounds(chunkCount + 1, size);
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunkCount; ++c) {
+        size_t pos = max(bounds[c - 1], size / chunkCount * c);
+        const void* newline = pos < size ? memchr(data + pos, '\n', size - pos) : nullptr;
+        bounds[c] = newline ? static_cast<const char*>(newline) - data + 1 : size;
+    }
+
+    vector<vector<Reservation>> parts(chunkCount);
+    runParallel(chunkCount, [&](size_t c) {
+        string_view chunk(data + bounds[c], bounds[c + 1] - bounds[c]);
+        parts[c].reserve(chunk.size() / 64);
+        while (!chunk.empty()) {
+            size_t end = chunk.find('\n');
+            string_view line = chunk.substr(0, end);
+            if (!line.empty()) {
+                parseLegacyReservationLine(line, parts[c]);  // malformed lines are skipped
+            }
+            chunk.remove_prefix(end == string_view::npos ? chunk.size() : end + 1);
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    vector<Reservation> merged;
+    merged.reserve(total);
+    for (auto& part : parts) {
+        move(part.begin(), part.end(), back_inserter(merged));
+    }
+    return merged;
+}
+
+// -------- Checksums --------
+// CRC32C (Castagnoli). x86-64 builds use the SSE4.2 crc32 instruction when the CPU
+// has it, ARM builds with the CRC extension use theirs, and everything else falls
+// back to a slicing-by-8 table.
+uint32_t crc32cSoftware(uint32_t crc, const char* data, size_t size) {
+    static const auto table = [] {
+        array<array<uint32_t, 256>, 8> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = value & 1 ? (value >> 1) ^ 0x82F63B78u : value >> 1;
+            }
+            t[0][i] = value;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+        return t;
+    }();
+    crc = ~crc;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));  // little-endian hosts only, like the snapshot
+        word ^= crc;
+        crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^ table[5][(word >> 16) & 0xFF] ^
+              table[4][(word >> 24) & 0xFF] ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^
+              table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+        data += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ table[0][(crc ^ static_cast<unsigned char>(*data++)) & 0xFF];
+    }
+    return ~crc;
+}
+
+#ifdef RESERVATION_SSE42_CRC
+__attribute__((target("sse4.2"))) uint32_t crc32cHardware(uint32_t crc, const char* data, size_t size) {
+    uint64_t value = ~crc;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        value = _mm_crc32_u64(value, word);
+        data += 8;
+        size -= 8;
+    }
+    uint32_t tail = static_cast<uint32_t>(value);
+    while (size--) {
+        tail = _mm_crc32_u8(tail, static_cast<unsigned char>(*data++));
+    }
+    return ~tail;
+}
+
+bool crc32cHardwareAvailable() {
+    static const bool available = __builtin_cpu_supports("sse4.2");
+    return available;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+uint32_t crc32cHardware(uint32_t crc, const char* data, size_t size) {
+    crc = ~crc;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = __crc32cb(crc, static_cast<uint8_t>(*data++));
+    }
+    return ~crc;
+}
+
+bool crc32cHardwareAvailable() { return true; }
+#else
+uint32_t crc32cHardware(uint32_t crc, const char* data, size_t size) { return crc32cSoftware(crc, data, size); }
+
+bool crc32cHardwareAvailable() { return false; }
+#endif
+
+// Pass the previous result as crc to checksum data that arrives in pieces.
+uint32_t crc32c(const char* data, size_t size, uint32_t crc = 0) {
+    return crc32cHardwareAvailable() ? crc32cHardware(crc, data, size) : crc32cSoftware(crc, data, size);
+}
+
+// -------- Write-Ahead Journal --------
+// Every mutation appends one line to reservations.journal instead of rewriting
+// the snapshot. Each line starts with a log sequence number (LSN):
+//   <lsn>|R|<id>|<name>|<phone>|<party>|<date>|<time>|<table>          reserve
+//   <lsn>|U|<oldId>|<id>|<name>|<phone>|<party>|<date>|<time>|<table>  update
+//   <lsn>|C|<id>                                                       cancel
+//   <lsn>|T|<unix millis>                                              clock
+// A clock record precedes the first record of every wall-clock second (and opens
+// every journal file), so point-in-time restore can tell when records happened.
+// The snapshot records the LSN it already covers, so replay skips anything older.
+// A checkpoint first rotates the journal to reservations.journal.old and, once
+// the snapshot is durable, moves it into the checkpoint history.
+// Each line ends in "#<crc32c of the rest, 8 hex digits>". Journals from before
+// checksums have no suffix and are accepted until the first checksummed line.
+const string JOURNAL_FILE = "reservations.journal";
+const string ROTATED_JOURNAL_FILE = "reservations.journal.old";
+const size_t JOURNAL_CHECKSUM_LENGTH = 9;  // '#' and 8 hex digits
+
+long long wallClockMillis() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+string journalLine(const string& payload) {
+    char suffix[JOURNAL_CHECKSUM_LENGTH + 2];
+    snprintf(suffix, sizeof(suffix), "#%08x\n", crc32c(payload.data(), payload.size()));
+    return payload + suffix;
+}
+
+// Splits the checksum off a journal line (without its newline). Returns false if
+// the checksum does not match; a line without one comes back whole with
+// hasChecksum set to false.
+bool verifyJournalLine(string_view line, string_view& payload, bool& hasChecksum) {
+    payload = line;
+    hasChecksum = false;
+    if (line.size() < JOURNAL_CHECKSUM_LENGTH || line[line.size() - JOURNAL_CHECKSUM_LENGTH] != '#') {
+        return true;
+    }
+    uint32_t expected;
+    string_view digits = line.substr(line.size() - JOURNAL_CHECKSUM_LENGTH + 1);
+    auto result = from_chars(digits.data(), digits.data() + digits.size(), expected, 16);
+    if (result.ec != errc() || result.ptr != digits.data() + digits.size()) {
+        return true;
+    }
+    hasChecksum = true;
+    payload = line.substr(0, line.size() - JOURNAL_CHECKSUM_LENGTH);
+    return crc32c(payload.data(), payload.size()) == expected;
+}
+
+// One sequential pass over a journal image: calls visit(payload) for each intact
+// record and stops at the first one that is torn (no newline), fails its checksum,
+// lacks a checksum after checksummed records, or is rejected by visit. Returns the
+// length of the intact prefix, which is where recovery truncates the file.
+template <typename Visitor>
+size_t scanJournal(const char* data, size_t size, Visitor visit) {
+    size_t offset = 0;
+    bool sawChecksum = false;
+    while (offset < size) {
+        const char* end = static_cast<const char*>(memchr(data + offset, '\n', size - offset));
+        if (!end) {
+            break;
+        }
+        string_view payload;
+        bool hasChecksum;
+        if (!verifyJournalLine(string_view(data + offset, end - (data + offset)), payload, hasChecksum) ||
+            (sawChecksum && !hasChecksum)) {
+            break;
+        }
+        sawChecksum = sawChecksum || hasChecksum;
+        if (!visit(payload)) {
+            break;
+        }
+        offset = static_cast<size_t>(end - data) + 1;
+    }
+    return offset;
+}
+
+vector<string> splitFields(const string& line, char delim) {
+    vector<string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(delim, start);
+        if (end == string::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+string formatReservationFields(const Reservation& res) {
+    string line;
+    line.reserve(res.customerName.size() + res.phoneNumber.size() + res.date.size() + res.time.size() + 56);
+    appendReservationId(line, res.id);
+    line.append(1, '|').append(res.customerName).append(1, '|').append(res.phoneNumber);
+    line.append(1, '|').append(to_string(res.partySize)).append(1, '|').append(res.date).append(1, '|');
+    line.append(res.time).append(1, '|').append(to_string(res.tableNumber));
+    return line;
+}
+
+// -------- On-Disk Format Versions --------
+// Every file the store writes names its format, so a build meeting a newer file
+// refuses it instead of misreading it (or truncating a journal it cannot parse).
+// Text files start with a "<tag>|<version>" line, checksummed where the rest of
+// the file is; binary files carry the version in their magic. Text files without
+// the line are version 1.
+const string JOURNAL_TAG = "RSVJOURNAL";
+const string ACCOUNTS_TAG = "RSVACCOUNTS";
+const string MANIFEST_TAG = "RSVMANIFEST";
+const int JOURNAL_FORMAT_VERSION = 3;  // 3 added clock records
+const int ACCOUNTS_FORMAT_VERSION = 2;
+const int MANIFEST_FORMAT_VERSION = 2;
+
+string formatHeader(const string& tag, int version) {
+    return tag + "|" + to_string(version);
+}
+
+// True if payload is tag's header line. Throws if it names a version newer than
+// supportedVersion.
+bool checkFormatHeader(string_view payload, const string& tag, int supportedVersion) {
+    if (payload.size() <= tag.size() + 1 || payload.substr(0, tag.size()) != tag || payload[tag.size()] != '|') {
+        return false;
+    }
+    int version;
+    if (!parseInteger(payload.substr(tag.size() + 1), version)) {
+        return false;
+    }
+    if (version > supportedVersion) {
+        throw ReservationException(tag + " format version " + to_string(version) +
+                                   " is newer than this program supports (" + to_string(supportedVersion) + ").");
+    }
+    return true;
+}
+
+// -------- Memory-Mapped Files --------
+// Read-only view of a whole file. Pages are faulted in only when touched.
+// Windows builds read the file into memory instead.
+class MappedFile {
+    const char* bytes;
+    size_t length;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+public:
+    explicit MappedFile(const string& path) : bytes(nullptr), length(0) {
+#ifdef _WIN32
+        ifstream file(path, ios::binary);
+        if (file.is_open()) {
+            buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+            bytes = buffer.data();
+            length = buffer.size();
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                bytes = static_cast<const char*>(mapped);
+                length = static_cast<size_t>(info.st_size);
             }
-            resFile.close();
         }
+        close(fd);
+#endif
+    }
+    ~MappedFile() {
+#ifndef _WIN32
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return bytes != nullptr; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// -------- Binary Snapshot Format --------
+// reservations.bin: a header, then one fixed-width record per reservation, then a
+// heap holding the id/name/phone bytes that the records point into, then the
+// CRC32C of everything before it. Integers are stored in host byte order; the
+// snapshot is not meant to move between machines. Snapshots written before the
+// checksum trailer end at the heap and are read unverified.
+const string SNAPSHOT_FILE = "reservations.bin";
+const char SNAPSHOT_MAGIC[8] = {'R', 'S', 'V', 'S', 'N', 'A', 'P', '1'};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint64_t recordCount;
+    int64_t snapshotLsn;
+    uint64_t stringHeapOffset;
+    uint64_t stringHeapSize;
+};
+
+struct PackedReservation {
+    uint32_t idOffset;     // offsets are relative to the string heap
+    uint32_t nameOffset;
+    uint32_t phoneOffset;
+    uint16_t idLength;
+    uint16_t nameLength;
+    uint16_t phoneLength;
+    uint16_t time;         // minutes since midnight
+    uint32_t date;         // year << 9 | month << 5 | day
+    uint32_t partySize;
+    int32_t tableNumber;
+};
+
+static_assert(sizeof(PackedReservation) == 32, "PackedReservation must stay fixed-width");
+
+// Bytes a reservation takes in a snapshot: its record plus its heap strings.
+size_t packedReservationBytes(const Reservation& res) {
+    return sizeof(PackedReservation) + reservationIdLength(res.id) + res.customerName.size() + res.phoneNumber.size();
+}
+
+uint32_t packDate(const string& date) {
+    int year = 0, month = 0, day = 0;
+    if (sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+        return 0;
+    }
+    return static_cast<uint32_t>(year) << 9 | static_cast<uint32_t>(month) << 5 | static_cast<uint32_t>(day);
+}
+
+string unpackDate(uint32_t packed) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u", packed >> 9, (packed >> 5) & 0xF, packed & 0x1F);
+    return buffer;
+}
+
+uint16_t packTime(const string& time) {
+    int hour = 0, minute = 0;
+    if (sscanf(time.c_str(), "%d:%d", &hour, &minute) != 2) {
+        return 0;
+    }
+    return static_cast<uint16_t>(hour * 60 + minute);
+}
+
+string unpackTime(uint16_t packed) {
+    char buffer[8];
+    snprintf(buffer, sizeof(buffer), "%02u:%02u", packed / 60u, packed % 60u);
+    return buffer;
+}
+
+void writeBinarySnapshot(const string& path, const vector<Reservation>& snapshot, long long snapshotLsn) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw ReservationException("Unable to open " + path + " for writing.");
+    }
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.recordCount = snapshot.size();
+    header.snapshotLsn = snapshotLsn;
+    header.stringHeapOffset = sizeof(SnapshotHeader) + snapshot.size() * sizeof(PackedReservation);
+    header.stringHeapSize = 0;
+    for (const auto& res : snapshot) {
+        header.stringHeapSize += reservationIdLength(res.id) + res.customerName.size() + res.phoneNumber.size();
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint32_t crc = crc32c(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t heapSize = 0;
+    auto placeString = [&heapSize](size_t size, uint32_t& offset, uint16_t& length) {
+        if (size > UINT16_MAX || heapSize + size > UINT32_MAX) {
+            throw ReservationException("Reservation field too large for snapshot.");
+        }
+        offset = static_cast<uint32_t>(heapSize);
+        length = static_cast<uint16_t>(size);
+        heapSize += size;
+    };
+    for (const auto& res : snapshot) {
+        PackedReservation packed;
+        placeString(reservationIdLength(res.id), packed.idOffset, packed.idLength);
+        placeString(res.customerName.size(), packed.nameOffset, packed.nameLength);
+        placeString(res.phoneNumber.size(), packed.phoneOffset, packed.phoneLength);
+        packed.time = packTime(res.time);
+        packed.date = packDate(res.date);
+        packed.partySize = static_cast<uint32_t>(res.partySize);
+        packed.tableNumber = res.tableNumber;
+        file.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+        crc = crc32c(reinterpret_cast<const char*>(&packed), sizeof(packed), crc);
+    }
+    for (const auto& res : snapshot) {
+        string id = formatReservationId(res.id);
+        file << id << res.customerName << res.phoneNumber;
+        crc = crc32c(id.data(), id.size(), crc);
+        crc = crc32c(res.customerName.data(), res.customerName.size(), crc);
+        crc = crc32c(res.phoneNumber.data(), res.phoneNumber.size(), crc);
+    }
+    file.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    file.close();
+    if (!file) {
+        throw ReservationException("Unable to write " + path + ".");
+    }
+}
+
+// Validated view over a mapped snapshot. Records are decoded one at a time straight
+// out of the mapping; there is no text to parse.
+class BinarySnapshotView {
+    SnapshotHeader header;
+    const char* base;
+    const char* records;
+    const char* heap;
+    bool hasChecksum;
+
+    string_view field(uint32_t offset, uint16_t length) const {
+        if (static_cast<uint64_t>(offset) + length > header.stringHeapSize) {
+            throw ReservationException("Corrupt reservations snapshot: string out of range.");
+        }
+        return string_view(heap + offset, length);
+    }
+
+    PackedReservation packed(size_t i) const {
+        PackedReservation record;
+        memcpy(&record, records + i * sizeof(PackedReservation), sizeof(record));
+        return record;
+    }
+
+public:
+    explicit BinarySnapshotView(const MappedFile& file) {
+        if (file.size() < sizeof(SnapshotHeader)) {
+            throw ReservationException("Corrupt reservations snapshot: truncated header.");
+        }
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.recordCount > (file.size() - sizeof(SnapshotHeader)) / sizeof(PackedReservation) ||
+            header.stringHeapOffset != sizeof(SnapshotHeader) + header.recordCount * sizeof(PackedReservation) ||
+            header.stringHeapSize > file.size() - header.stringHeapOffset) {
+            throw ReservationException("Corrupt reservations snapshot: bad header.");
+        }
+        base = file.data();
+        records = file.data() + sizeof(SnapshotHeader);
+        heap = file.data() + header.stringHeapOffset;
+        hasChecksum = file.size() == header.stringHeapOffset + header.stringHeapSize + sizeof(uint32_t);
+    }
+
+    // Checks the CRC32C trailer; called before a snapshot is loaded, not on ID probes.
+    void verify() const {
+        if (!hasChecksum) {
+            return;
+        }
+        size_t length = static_cast<size_t>(header.stringHeapOffset + header.stringHeapSize);
+        uint32_t stored;
+        memcpy(&stored, base + length, sizeof(stored));
+        if (crc32c(base, length) != stored) {
+            throw ReservationException("Corrupt reservations snapshot: checksum mismatch.");
+        }
+    }
+
+    size_t size() const { return static_cast<size_t>(header.recordCount); }
+    long long snapshotLsn() const { return header.snapshotLsn; }
+
+    long long id(size_t i) const {
+        PackedReservation record = packed(i);
+        return parseReservationIdOrInvalid(field(record.idOffset, record.idLength));
+    }
+
+    string_view customerName(size_t i) const {
+        PackedReservation record = packed(i);
+        return field(record.nameOffset, record.nameLength);
+    }
+
+    string_view phoneNumber(size_t i) const {
+        PackedReservation record = packed(i);
+        return field(record.phoneOffset, record.phoneLength);
+    }
+
+    // Minutes since midnight (packTime).
+    uint16_t minute(size_t i) const { return packed(i).time; }
+
+    Reservation reservation(size_t i) const {
+        PackedReservation record = packed(i);
+        return Reservation(parseReservationIdOrInvalid(field(record.idOffset, record.idLength)),
+                           string(field(record.nameOffset, record.nameLength)),
+                           string(field(record.phoneOffset, record.phoneLength)), static_cast<int>(record.partySize),
+                           unpackDate(record.date), unpackTime(record.time), record.tableNumber);
+    }
+};
+
+// Calls visit(reservation) for each record and returns the snapshot LSN.
+template <typename Visitor>
+long long readBinarySnapshot(const MappedFile& file, Visitor visit) {
+    BinarySnapshotView view(file);
+    view.verify();
+    for (size_t i = 0; i < view.size(); ++i) {
+        visit(view.reservation(i));
+    }
+    return view.snapshotLsn();
+}
+
+// -------- Date Segments --------
+// Checkpoints store one binary snapshot per reservation date under segments/, plus
+// segments/manifest.txt listing every segment:
+//   RSVMANIFEST|<version>
+//   <snapshotLsn>|<nextReservationId>
+//   <date>|<records>|<tableMask>
+// Startup reads only the manifest and the segments inside the active window
+// (today onwards for activeWindowDays); other dates are loaded the first time they
+// are touched and evicted again once idle. tableMask keeps table availability
+// right without loading every segment.
+const string SEGMENT_DIR = "segments";
+const string MANIFEST_FILE = SEGMENT_DIR + "/manifest.txt";
+
+// Records whose date is not YYYY-MM-DD shaped (only possible in legacy data) share
+// one segment so they can never produce a strange file name.
+string segmentKeyFor(const string& date) {
+    return isDateShaped(date) ? date : "undated";
+}
+
+string segmentPath(const string& key) {
+    return SEGMENT_DIR + "/" + key + ".bin";
+}
+
+string manifestHeader(long long snapshotLsn, long long nextReservationId) {
+    return formatHeader(MANIFEST_TAG, MANIFEST_FORMAT_VERSION) + "\n" + to_string(snapshotLsn) + "|" +
+           to_string(nextReservationId) + "\n";
+}
+
+// -------- Columnar Archive Format --------
+// Archive files store each field as its own column:
+//   ids      zigzag varint delta of the number in "ID <n>A"; other IDs inline
+//   names    dictionary of distinct names, then bit-packed dictionary codes
+//   phones   same as names
+//   dates    zigzag varint delta of the packed date
+//   times    zigzag varint delta of minutes since midnight
+//   party    bit-packed zigzag party sizes
+//   tables   bit-packed zigzag table numbers
+// Records are sorted by date, time and ID first, so the deltas stay small. A
+// CRC32C of everything before it closes the file.
+const char ARCHIVE_MAGIC[8] = {'R', 'S', 'V', 'A', 'R', 'C', 'H', '1'};
+
+enum ArchiveColumn { IdColumn, NameDictionary, PhoneDictionary, NameCodes, PhoneCodes, DateColumn, TimeColumn,
+                     PartyColumn, TableColumn, ArchiveColumnCount };
+
+struct ArchiveHeader {
+    char magic[8];
+    uint64_t recordCount;
+    int64_t snapshotLsn;
+    uint32_t nameBits, phoneBits, partyBits, tableBits;
+    uint64_t columnSize[ArchiveColumnCount];
+};
+
+static_assert(sizeof(ArchiveHeader) == 112, "ArchiveHeader must stay fixed-width");
+
+void putVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t getVarint(const char*& cursor, const char* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) break;
+        unsigned char byte = static_cast<unsigned char>(*cursor++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw ReservationException("Corrupt reservation archive: bad varint.");
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+unsigned bitsFor(uint64_t maxValue) {
+    unsigned bits = 0;
+    while (maxValue) {
+        bits++;
+        maxValue >>= 1;
+    }
+    return bits;
+}
+
+// Little-endian bit packing of values up to 32 bits wide.
+class BitWriter {
+    string& out;
+    uint64_t pending;
+    unsigned pendingBits;
+public:
+    explicit BitWriter(string& target) : out(target), pending(0), pendingBits(0) {}
+    void put(uint64_t value, unsigned width) {
+        pending |= value << pendingBits;
+        pendingBits += width;
+        while (pendingBits >= 8) {
+            out.push_back(static_cast<char>(pending & 0xFF));
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+    void finish() {
+        if (pendingBits > 0) out.push_back(static_cast<char>(pending));
+        pending = 0;
+        pendingBits = 0;
+    }
+};
+
+class BitReader {
+    const unsigned char* cursor;
+    const unsigned char* end;
+    uint64_t pending;
+    unsigned pendingBits;
+public:
+    BitReader(const char* data, size_t size)
+        : cursor(reinterpret_cast<const unsigned char*>(data)), end(cursor + size), pending(0), pendingBits(0) {}
+    uint64_t get(unsigned width) {
+        while (pendingBits < width) {
+            if (cursor == end) throw ReservationException("Corrupt reservation archive: packed column too short.");
+            pending |= static_cast<uint64_t>(*cursor++) << pendingBits;
+            pendingBits += 8;
+        }
+        uint64_t value = pending & ((uint64_t(1) << width) - 1);
+        pending >>= width;
+        pendingBits -= width;
+        return value;
+    }
+};
+
+// One decoded archive record. Name and phone point into the mapped dictionary, so
+// nothing is allocated per record.
+struct ArchivedReservation {
+    long long id;
+    string_view customerName;
+    string_view phoneNumber;
+    uint32_t date;    // packDate() form
+    uint16_t time;    // minutes since midnight
+    int partySize;
+    int tableNumber;
+
+    Reservation toReservation() const {
+        return Reservation(id, string(customerName), string(phoneNumber), partySize, unpackDate(date),
+                           unpackTime(time), tableNumber);
+    }
+};
+
+string encodeArchive(const vector<Reservation>& input, long long snapshotLsn) {
+    // Sort on precomputed (date, time) keys so each date is parsed once.
+    vector<pair<uint64_t, size_t>> order(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        order[i] = {static_cast<uint64_t>(packDate(input[i].date)) << 16 | packTime(input[i].time), i};
+    }
+    sort(order.begin(), order.end(), [&input](const pair<uint64_t, size_t>& a, const pair<uint64_t, size_t>& b) {
+        return a.first != b.first ? a.first < b.first : input[a.second].id < input[b.second].id;
+    });
+    vector<Reservation> records;
+    records.reserve(input.size());
+    for (const auto& entry : order) {
+        records.push_back(input[entry.second]);
+    }
+
+    string columns[ArchiveColumnCount];
+    auto buildDictionary = [&records](string Reservation::*field, string& dictionary, vector<uint32_t>& codes) {
+        unordered_map<string_view, uint32_t> index;
+        codes.reserve(records.size());
+        vector<string_view> entries;
+        for (const auto& res : records) {
+            auto inserted = index.emplace(res.*field, static_cast<uint32_t>(entries.size()));
+            if (inserted.second) entries.push_back(res.*field);
+            codes.push_back(inserted.first->second);
+        }
+        putVarint(dictionary, entries.size());
+        for (const auto& entry : entries) {
+            putVarint(dictionary, entry.size());
+            dictionary.append(entry.data(), entry.size());
+        }
+        return bitsFor(entries.empty() ? 0 : entries.size() - 1);
+    };
+    vector<uint32_t> nameCodes, phoneCodes;
+    ArchiveHeader header;
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.recordCount = records.size();
+    header.snapshotLsn = snapshotLsn;
+    header.nameBits = buildDictionary(&Reservation::customerName, columns[NameDictionary], nameCodes);
+    header.phoneBits = buildDictionary(&Reservation::phoneNumber, columns[PhoneDictionary], phoneCodes);
+
+    uint64_t maxParty = 0, maxTable = 0;
+    for (const auto& res : records) {
+        maxParty = max(maxParty, zigzag(res.partySize));
+        maxTable = max(maxTable, zigzag(res.tableNumber));
+    }
+    header.partyBits = bitsFor(maxParty);
+    header.tableBits = bitsFor(maxTable);
+
+    BitWriter names(columns[NameCodes]), phones(columns[PhoneCodes]);
+    BitWriter party(columns[PartyColumn]), table(columns[TableColumn]);
+    long long previousNumber = 0;
+    int64_t previousDate = 0, previousTime = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const Reservation& res = records[i];
+        putVarint(columns[IdColumn], zigzag(res.id - previousNumber) << 1);
+        previousNumber = res.id;
+        names.put(nameCodes[i], header.nameBits);
+        phones.put(phoneCodes[i], header.phoneBits);
+        int64_t date = static_cast<int64_t>(order[i].first >> 16), time = static_cast<int64_t>(order[i].first & 0xFFFF);
+        putVarint(columns[DateColumn], zigzag(date - previousDate));
+        putVarint(columns[TimeColumn], zigzag(time - previousTime));
+        previousDate = date;
+        previousTime = time;
+        party.put(zigzag(res.partySize), header.partyBits);
+        table.put(zigzag(res.tableNumber), header.tableBits);
+    }
+    names.finish();
+    phones.finish();
+    party.finish();
+    table.finish();
+
+    for (int c = 0; c < ArchiveColumnCount; ++c) {
+        header.columnSize[c] = columns[c].size();
+    }
+    string file(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& column : columns) {
+        file += column;
+    }
+    uint32_t crc = crc32c(file.data(), file.size());
+    file.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    return file;
+}
+
+void writeArchiveFile(const string& path, const vector<Reservation>& records, long long snapshotLsn) {
+    string encoded = encodeArchive(records, snapshotLsn);
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw ReservationException("Unable to open " + path + " for writing.");
+    }
+    file.write(encoded.data(), static_cast<streamsize>(encoded.size()));
+    file.close();
+    if (!file) {
+        throw ReservationException("Unable to write " + path + ".");
+    }
+}
+
+class ArchiveView {
+    ArchiveHeader header;
+    const char* base;
+    size_t length;
+    const char* columns[ArchiveColumnCount];
+    vector<string_view> names;
+    vector<string_view> phones;
+
+    void readDictionary(ArchiveColumn column, vector<string_view>& entries) const {
+        const char* cursor = columns[column];
+        const char* end = cursor + header.columnSize[column];
+        uint64_t count = getVarint(cursor, end);
+        if (count > header.columnSize[column]) {
+            throw ReservationException("Corrupt reservation archive: bad dictionary.");
+        }
+        entries.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t size = getVarint(cursor, end);
+            if (size > static_cast<uint64_t>(end - cursor)) {
+                throw ReservationException("Corrupt reservation archive: bad dictionary.");
+            }
+            entries.emplace_back(cursor, static_cast<size_t>(size));
+            cursor += size;
+        }
+    }
+
+public:
+    explicit ArchiveView(const MappedFile& file) : base(file.data()), length(file.size()) {
+        if (length < sizeof(ArchiveHeader) + sizeof(uint32_t)) {
+            throw ReservationException("Corrupt reservation archive: truncated header.");
+        }
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) != 0 || header.nameBits > 32 ||
+            header.phoneBits > 32 || header.partyBits > 32 || header.tableBits > 32) {
+            throw ReservationException("Corrupt reservation archive: bad header.");
+        }
+        uint64_t offset = sizeof(ArchiveHeader);
+        for (int c = 0; c < ArchiveColumnCount; ++c) {
+            if (header.columnSize[c] > length - sizeof(uint32_t) - offset) {
+                throw ReservationException("Corrupt reservation archive: column out of range.");
+            }
+            columns[c] = base + offset;
+            offset += header.columnSize[c];
+        }
+        if (offset + sizeof(uint32_t) != length) {
+            throw ReservationException("Corrupt reservation archive: bad length.");
+        }
+        readDictionary(NameDictionary, names);
+        readDictionary(PhoneDictionary, phones);
+    }
+
+    size_t size() const { return static_cast<size_t>(header.recordCount); }
+    long long snapshotLsn() const { return header.snapshotLsn; }
+
+    void verify() const {
+        uint32_t stored;
+        memcpy(&stored, base + length - sizeof(stored), sizeof(stored));
+        if (crc32c(base, length - sizeof(stored)) != stored) {
+            throw ReservationException("Corrupt reservation archive: checksum mismatch.");
+        }
+    }
+
+    // Decodes the records in order; only the columns a record needs are touched.
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        const char* ids = columns[IdColumn];
+        const char* idsEnd = ids + header.columnSize[IdColumn];
+        const char* dates = columns[DateColumn];
+        const char* datesEnd = dates + header.columnSize[DateColumn];
+        const char* times = columns[TimeColumn];
+        const char* timesEnd = times + header.columnSize[TimeColumn];
+        BitReader nameCodes(columns[NameCodes], header.columnSize[NameCodes]);
+        BitReader phoneCodes(columns[PhoneCodes], header.columnSize[PhoneCodes]);
+        BitReader party(columns[PartyColumn], header.columnSize[PartyColumn]);
+        BitReader table(columns[TableColumn], header.columnSize[TableColumn]);
+        long long number = 0;
+        int64_t date = 0, time = 0;
+        ArchivedReservation record;
+        for (uint64_t i = 0; i < header.recordCount; ++i) {
+            uint64_t idCode = getVarint(ids, idsEnd);
+            if (idCode & 1) {
+                // Older archives spelled out IDs that were not of the "ID <n>A" form.
+                size_t size = static_cast<size_t>(idCode >> 1);
+                if (size > static_cast<size_t>(idsEnd - ids)) {
+                    throw ReservationException("Corrupt reservation archive: bad ID.");
+                }
+                record.id = parseReservationIdOrInvalid(string_view(ids, size));
+                ids += size;
+            } else {
+                number += unzigzag(idCode >> 1);
+                record.id = number;
+            }
+            uint64_t nameCode = nameCodes.get(header.nameBits);
+            uint64_t phoneCode = phoneCodes.get(header.phoneBits);
+            if (nameCode >= names.size() || phoneCode >= phones.size()) {
+                throw ReservationException("Corrupt reservation archive: bad dictionary code.");
+            }
+            record.customerName = names[static_cast<size_t>(nameCode)];
+            record.phoneNumber = phones[static_cast<size_t>(phoneCode)];
+            date += unzigzag(getVarint(dates, datesEnd));
+            time += unzigzag(getVarint(times, timesEnd));
+            record.date = static_cast<uint32_t>(date);
+            record.time = static_cast<uint16_t>(time);
+            record.partySize = static_cast<int>(unzigzag(party.get(header.partyBits)));
+            record.tableNumber = static_cast<int>(unzigzag(table.get(header.tableBits)));
+            visit(record);
+        }
+    }
+};
+
+// -------- Archive Tier --------
+// Segments older than archiveHorizonDays leave the hot set at the next checkpoint
+// and are merged into one read-only columnar file per month under archive/.
+// Archived reservations no longer hold a table and cannot be changed; they are
+// read only when someone asks for them. Months archived before the columnar
+// format are .bin snapshots and are converted the next time they grow.
+const string ARCHIVE_DIR = "archive";
+
+string archivePath(const string& month) {
+    return ARCHIVE_DIR + "/" + month + ".arc";
+}
+
+string legacyArchivePath(const string& month) {
+    return ARCHIVE_DIR + "/" + month + ".bin";
+}
+
+// Archive files in month order.
+vector<string> archiveFiles() {
+    vector<string> files;
+    error_code ec;
+    for (filesystem::directory_iterator it(ARCHIVE_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".arc" || it->path().extension() == ".bin") {
+            files.push_back(it->path().string());
+        }
+    }
+    sort(files.begin(), files.end());
+    return files;
+}
+
+// Calls visit(ArchivedReservation) for every record of one archive file, in
+// either format, and returns the record count.
+template <typename Visitor>
+size_t readArchiveFile(const string& path, Visitor visit) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        return 0;
+    }
+    if (file.size() >= sizeof(ARCHIVE_MAGIC) && memcmp(file.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0) {
+        ArchiveView view(file);
+        view.verify();
+        view.forEach(visit);
+        return view.size();
+    }
+    BinarySnapshotView view(file);
+    view.verify();
+    for (size_t i = 0; i < view.size(); ++i) {
+        Reservation res = view.reservation(i);
+        visit(ArchivedReservation{res.id, res.customerName, res.phoneNumber, packDate(res.date), packTime(res.time),
+                                  res.partySize, res.tableNumber});
+    }
+    return view.size();
+}
+
+// Adds reservations to their month's archive file, skipping IDs it already holds
+// (left behind if a checkpoint died before dropping the segment). Each file is
+// rewritten whole and replaced atomically, so readers never see a partial archive.
+void archiveReservations(const map<string, vector<Reservation>>& byMonth, long long snapshotLsn) {
+    filesystem::create_directories(ARCHIVE_DIR);
+    for (const auto& month : byMonth) {
+        vector<Reservation> merged;
+        unordered_set<long long> archivedIds;
+        for (const auto& path : {legacyArchivePath(month.first), archivePath(month.first)}) {
+            readArchiveFile(path, [&](const ArchivedReservation& record) {
+                if (record.id < 0 || archivedIds.insert(record.id).second) {
+                    merged.push_back(record.toReservation());
+                }
+            });
+        }
+        for (const auto& res : month.second) {
+            if (res.id < 0 || archivedIds.insert(res.id).second) {
+                merged.push_back(res);
+            }
+        }
+        const string temp = archivePath(month.first) + ".tmp";
+        writeArchiveFile(temp, merged, snapshotLsn);
+        commitFile(temp, archivePath(month.first));
+        error_code ec;
+        filesystem::remove(legacyArchivePath(month.first), ec);
+    }
+}
+
+// -------- Legacy Store Migration --------
+// Converts the files older versions wrote into the current formats in one pass,
+// streaming so memory stays flat however large they are:
+//   reservations.txt / reservations.bin + next_id.txt -> date segments + manifest
+//   customer_accounts.txt without a header            -> versioned account log
+// Reservations are read in fixed-size chunks and spilled to one text file per
+// date; each spill then becomes a segment, so peak memory is one chunk or the
+// busiest single date. The legacy files are removed only after the manifest is
+// durable, and a crash before that simply runs the migration again.
+struct MigrationStats {
+    size_t reservations = 0;
+    size_t segments = 0;
+    size_t accounts = 0;
+    long long bytesRead = 0;
+};
+
+const size_t MIGRATION_CHUNK_BYTES = 4 << 20;
+const size_t MIGRATION_OPEN_SPILLS = 256;
+
+// Feeds a file to visit(data, size) in newline-aligned pieces of about chunkBytes
+// through one reusable buffer; a final line without a newline is passed too.
+template <typename Visitor>
+long long forEachLineChunk(const string& path, size_t chunkBytes, Visitor visit) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+    vector<char> buffer(chunkBytes);
+    size_t carried = 0;
+    long long total = 0;
+    while (true) {
+        if (carried == buffer.size()) {
+            buffer.resize(buffer.size() * 2);  // a single line longer than the buffer
+        }
+        file.read(buffer.data() + carried, static_cast<streamsize>(buffer.size() - carried));
+        size_t filled = carried + static_cast<size_t>(file.gcount());
+        total += file.gcount();
+        if (filled == 0) {
+            break;
+        }
+        if (file.gcount() == 0) {
+            visit(buffer.data(), filled);
+            break;
+        }
+        size_t cut = filled;
+        while (cut > 0 && buffer[cut - 1] != '\n') cut--;
+        if (cut == 0) {
+            carried = filled;
+            continue;
+        }
+        visit(buffer.data(), cut);
+        carried = filled - cut;
+        memmove(buffer.data(), buffer.data() + cut, carried);
+    }
+    return total;
+}
+
+class SegmentSpiller {
+    struct DateSummary {
+        size_t records = 0;
+        uint32_t tableMask = 0;
+    };
+    map<string, DateSummary> dates;
+    unordered_map<string, ofstream> open;
+    string root;
+
+    string spillPath(const string& key) const { return root + SEGMENT_DIR + "/" + key + ".spill"; }
+
+public:
+    long long maxReservationNumber = 0;
+
+    // root is prefixed to the segment paths: "" for the store itself, or "<dir>/".
+    explicit SegmentSpiller(const string& root = "") : root(root) {}
+
+    void add(const Reservation& res) {
+        string key = segmentKeyFor(res.date);
+        DateSummary& summary = dates[key];
+        summary.records++;
+        if (res.tableNumber >= 0 && res.tableNumber < 32) summary.tableMask |= 1u << res.tableNumber;
+        maxReservationNumber = max(maxReservationNumber, res.id);
+
+        auto it = open.find(key);
+        if (it == open.end()) {
+            if (open.size() >= MIGRATION_OPEN_SPILLS) open.clear();
+            it = open.emplace(key, ofstream(spillPath(key), ios::binary | ios::app)).first;
+            if (!it->second.is_open()) {
+                throw ReservationException("Unable to open " + spillPath(key) + " for writing.");
+            }
+        }
+        it->second << formatReservationFields(res) << '\n';
+    }
+
+    bool holds(const string& key) const { return dates.count(key) > 0; }
+
+    // Turns every spill file into a segment and returns the manifest's segment lines.
+    string finish(long long snapshotLsn, size_t& segmentCount) {
+        open.clear();
+        ostringstream lines;
+        for (const auto& date : dates) {
+            vector<Reservation> records;
+            {
+                MappedFile spill(spillPath(date.first));
+                if (spill.isOpen()) records = parseLegacyReservations(spill.data(), spill.size());
+            }
+            const string temp = root + segmentPath(date.first) + ".tmp";
+            writeBinarySnapshot(temp, records, snapshotLsn);
+            commitFile(temp, root + segmentPath(date.first));
+            error_code ec;
+            filesystem::remove(spillPath(date.first), ec);
+            lines << date.first << "|" << date.second.records << "|" << date.second.tableMask << "\n";
+            segmentCount++;
+        }
+        return lines.str();
+    }
+};
+
+// Returns false if there is no pre-segment store to migrate.
+bool migrateLegacyReservations(MigrationStats& stats) {
+    bool hasText = filesystem::exists("reservations.txt");
+    bool hasSnapshot = filesystem::exists(SNAPSHOT_FILE);
+    if (filesystem::exists(MANIFEST_FILE) || (!hasText && !hasSnapshot)) {
+        return false;
+    }
+    filesystem::create_directories(SEGMENT_DIR);
+    error_code ec;
+    for (filesystem::directory_iterator it(SEGMENT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".spill") {
+            filesystem::remove(it->path(), ec);  // left by an interrupted migration
+        }
+    }
+
+    SegmentSpiller spiller;
+    long long snapshotLsn = 0;
+    if (hasSnapshot) {
+        MappedFile snapshot(SNAPSHOT_FILE);
+        snapshotLsn = readBinarySnapshot(snapshot, [&](const Reservation& res) {
+            spiller.add(res);
+            stats.reservations++;
+        });
+        stats.bytesRead += static_cast<long long>(snapshot.size());
+    } else {
+        stats.bytesRead += forEachLineChunk("reservations.txt", MIGRATION_CHUNK_BYTES, [&](const char* data, size_t size) {
+            for (const auto& res : parseLegacyReservations(data, size)) {
+                spiller.add(res);
+                stats.reservations++;
+            }
+        });
+    }
+
+    long long nextId = spiller.maxReservationNumber + 1;
+    ifstream idFile("next_id.txt");
+    if (idFile.is_open()) {
+        long long savedId, savedLsn;
+        if (idFile >> savedId) nextId = max(nextId, savedId);
+        // Stores from before the binary snapshot kept the snapshot LSN here.
+        if (!hasSnapshot && idFile >> savedLsn) snapshotLsn = savedLsn;
+        idFile.close();
+    }
+
+    string segmentLines = spiller.finish(snapshotLsn, stats.segments);
+    writeFileAtomically(MANIFEST_FILE, manifestHeader(snapshotLsn, nextId) + segmentLines);
+    filesystem::remove("reservations.txt", ec);
+    filesystem::remove(SNAPSHOT_FILE, ec);
+    filesystem::remove("next_id.txt", ec);
+    return true;
+}
+
+// Rewrites a header-less account file as a versioned, checksummed log, line by
+// line. Returns false if the file is missing or already current.
+bool migrateLegacyAccounts(const string& path, MigrationStats& stats) {
+    {
+        ifstream file(path, ios::binary);
+        string first;
+        if (!file.is_open() || !getline(file, first)) {
+            return false;
+        }
+        string_view payload;
+        bool hasChecksum;
+        if (verifyJournalLine(first, payload, hasChecksum) && checkFormatHeader(payload, ACCOUNTS_TAG,
+                                                                                 ACCOUNTS_FORMAT_VERSION)) {
+            return false;
+        }
+    }
+    const string temp = path + ".tmp";
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            throw ReservationException("Unable to open " + temp + " for writing.");
+        }
+        out << journalLine(formatHeader(ACCOUNTS_TAG, ACCOUNTS_FORMAT_VERSION));
+        stats.bytesRead += forEachLineChunk(path, MIGRATION_CHUNK_BYTES, [&](const char* data, size_t size) {
+            string_view chunk(data, size);
+            while (!chunk.empty()) {
+                size_t end = min(chunk.find('\n'), chunk.size());
+                string_view payload;
+                bool hasChecksum;
+                // A corrupt or field-less line is dropped on its own.
+                if (verifyJournalLine(chunk.substr(0, end), payload, hasChecksum) &&
+                    payload.find('|') != string_view::npos) {
+                    out << journalLine(string(payload));
+                    stats.accounts++;
+                }
+                chunk.remove_prefix(min(end + 1, chunk.size()));
+            }
+        });
+        out.close();
+        if (!out) {
+            throw ReservationException("Unable to write " + temp + ".");
+        }
+    }
+    commitFile(temp, path);
+    return true;
+}
+
+// -------- CSV Import --------
+// Bookings exported from other systems arrive as CSV rows of
+//   customer,phone,party,date,time,table
+// with an optional header row and the 1-based table numbers the menus show.
+// Fields may be double-quoted ("" inside quotes is a literal quote). The file is
+// streamed in newline-aligned batches; each batch is validated on every worker
+// with the same rules as reserveTable, then committed behind one durability wait.
+const size_t IMPORT_BATCH_BYTES = 4 << 20;
+const size_t IMPORT_ROWS_PER_TASK = 4096;
+const string IMPORT_ERRORS_FILE = "import_errors.txt";
+
+struct ImportRow {
+    size_t line = 0;        // 1-based line number in the CSV
+    bool conflict = false;  // rejected because its table was already booked
+    string error;           // empty while the row is still importable
+    Reservation res;
+
+    ImportRow() : res(0, "", "", 0, "", "", -1) {}
+};
+
+struct ImportStats {
+    size_t rows = 0;
+    size_t imported = 0;
+    size_t rejected = 0;
+    size_t conflicts = 0;
+    long long bytes = 0;
+    double seconds = 0;
+};
+
+// False on an unterminated quote.
+bool splitCsvFields(string_view line, vector<string>& fields) {
+    fields.clear();
+    fields.emplace_back();
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c != '"') {
+                fields.back() += c;
+            } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    return !quoted;
+}
+
+bool isImportHeader(string_view line) {
+    vector<string> fields;
+    return splitCsvFields(line, fields) && toUpperCase(fields[0]) == "CUSTOMER";
+}
+
+// Fills row.res from one CSV line, or sets row.error. Safe to call from any worker.
+void validateImportRow(string_view line, ImportRow& row) {
+    vector<string> fields;
+    if (!splitCsvFields(line, fields)) {
+        row.error = "Unterminated quoted field.";
+        return;
+    }
+    if (fields.size() != 6) {
+        row.error = "Expected 6 fields (customer,phone,party,date,time,table), found " + to_string(fields.size()) + ".";
+        return;
+    }
+    int partySize, table;
+    if (!validateCustomerName(fields[0])) {
+        row.error = INVALID_NAME_MESSAGE;
+    } else if (!validatePhoneNumber(fields[1])) {
+        row.error = "Invalid phone number format. Use XXX-XXX-XXXX.";
+    } else if (!validateNumericInput(fields[2], partySize, 1, INT_MAX) || !validatePartySize(partySize)) {
+        row.error = "Party size must be at least 1.";
+    } else if (!validateDate(fields[3])) {
+        row.error = "Invalid date format (use YYYY-MM-DD) or date is in the past.";
+    } else if (!validateTime(fields[4], fields[3])) {
+        row.error = "Invalid time format (use HH:MM) or time is in the past for today.";
+    } else if (!validateNumericInput(fields[5], table, 1, TABLE_COUNT)) {
+        row.error = "Invalid table number. Must be between 1 and " + to_string(TABLE_COUNT) + ".";
+    } else {
+        row.res = Reservation(0, fields[0], fields[1], partySize, fields[3], fields[4], table - 1);
+    }
+}
+
+// -------- Reservation Export --------
+// Rows are formatted into one reusable buffer that goes to the stream in large
+// writes, so an export holds no copy of the store and never flushes per row.
+enum class ExportFormat { Table, Csv, JsonLines };
+
+const size_t EXPORT_BUFFER_BYTES = 1 << 16;
+
+bool parseExportFormat(const string& name, ExportFormat& format) {
+    string upper = toUpperCase(name);
+    if (upper == "CSV") {
+        format = ExportFormat::Csv;
+    } else if (upper == "JSONL" || upper == "JSON") {
+        format = ExportFormat::JsonLines;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct ExportFilter {
+    string fromDate;      // inclusive, YYYY-MM-DD; empty for no lower bound
+    string toDate;        // inclusive, YYYY-MM-DD; empty for no upper bound
+    string customerName;  // empty for every customer
+
+    bool matches(const Reservation& res) const {
+        if (!customerName.empty() && res.customerName != customerName) return false;
+        if (fromDate.empty() && toDate.empty()) return true;
+        return isDateShaped(res.date) && (fromDate.empty() || res.date >= fromDate) &&
+               (toDate.empty() || res.date <= toDate);
+    }
+};
+
+class ExportWriter {
+    ostream& out;
+    ExportFormat format;
+    string buffer;
+    size_t rowCount;
+
+    void appendNumber(long long value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+    }
+
+    void appendCsvField(const string& value) {
+        if (value.find_first_of(",\"\r\n") == string::npos) {
+            buffer += value;
+            return;
+        }
+        buffer += '"';
+        for (char c : value) {
+            if (c == '"') buffer += '"';
+            buffer += c;
+        }
+        buffer += '"';
+    }
+
+    void appendJsonString(const string& value) {
+        buffer += '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                buffer += '\\';
+                buffer += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                buffer += escaped;
+            } else {
+                buffer += c;
+            }
+        }
+        buffer += '"';
+    }
+
+    void writeHeader() {
+        if (format == ExportFormat::Table) {
+            buffer += "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
+        } else if (format == ExportFormat::Csv) {
+            buffer += "id,customer,phone,party,date,time,table\n";
+        }
+    }
+
+public:
+    ExportWriter(ostream& out, ExportFormat format) : out(out), format(format), rowCount(0) {
+        buffer.reserve(EXPORT_BUFFER_BYTES + 256);
+    }
+
+    void write(const Reservation& res) {
+        if (rowCount++ == 0) {
+            writeHeader();
+        }
+        switch (format) {
+            case ExportFormat::Table:
+                appendReservationId(buffer, res.id);
+                buffer.append(1, '\t').append(res.customerName).append(1, '\t');
+                appendNumber(res.partySize);
+                buffer.append(1, '\t').append(res.date).append(1, '\t').append(res.time).append(1, '\t');
+                buffer.append(res.phoneNumber).append(1, '\t');
+                appendNumber(res.tableNumber + 1);
+                break;
+            case ExportFormat::Csv:
+                appendReservationId(buffer, res.id);
+                buffer += ',';
+                appendCsvField(res.customerName);
+                buffer += ',';
+                appendCsvField(res.phoneNumber);
+                buffer += ',';
+                appendNumber(res.partySize);
+                buffer += ',';
+                appendCsvField(res.date);
+                buffer += ',';
+                appendCsvField(res.time);
+                buffer += ',';
+                appendNumber(res.tableNumber + 1);
+                break;
+            case ExportFormat::JsonLines:
+                buffer += "{\"id\":\"";
+                appendReservationId(buffer, res.id);
+                buffer += '"';
+                buffer += ",\"customer\":";
+                appendJsonString(res.customerName);
+                buffer += ",\"phone\":";
+                appendJsonString(res.phoneNumber);
+                buffer += ",\"party\":";
+                appendNumber(res.partySize);
+                buffer += ",\"date\":";
+                appendJsonString(res.date);
+                buffer += ",\"time\":";
+                appendJsonString(res.time);
+                buffer += ",\"table\":";
+                appendNumber(res.tableNumber + 1);
+                buffer += '}';
+                break;
+        }
+        buffer += '\n';
+        if (buffer.size() >= EXPORT_BUFFER_BYTES) {
+            out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+
+    // Writes what is buffered and flushes the stream once.
+    void finish() {
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        buffer.clear();
+        out.flush();
+    }
+
+    size_t rows() const { return rowCount; }
+};
+
+// -------- Persistence Queue --------
+// A single I/O thread owns the journal and the activity log. Request threads only
+// append serialized lines to a bounded in-memory queue and get back a ticket; the
+// I/O thread writes each file's queued lines with one write() (plus one fsync for
+// the journal). waitDurable(ticket) blocks only as long as the durability mode
+// requires, so in async mode a mutation returns as soon as it is queued.
+enum class PersistedFile { Journal, Log };
+
+struct PersistenceStats {
+    size_t queuedRecords;           // appended but not yet handed to write()
+    size_t capacity;                // appends block once the queue holds this many
+    double oldestQueuedMillis;      // how long the oldest queued record has waited
+    uint64_t unsyncedJournalRecords;  // journal records not yet fsynced
+    double lastFlushMillis;         // duration of the most recent write+fsync batch
+    uint64_t flushes;
+};
+
+class PersistenceQueue {
+    struct QueuedFile {
+        int fd = -1;
+        bool syncOnFlush = false;
+        string header;  // written first whenever the file starts out empty
+        string pending;
+        size_t pendingOps = 0;
+        uint64_t appendedSeq = 0;
+        uint64_t durableSeq = 0;
+        long long bytes = 0;
+        chrono::steady_clock::time_point oldestPending;
+    };
+
+    DurabilityMode mode;
+    chrono::milliseconds groupCommitWindow;
+    size_t groupCommitOps;
+    size_t capacity;
+
+    // ioMutex serialises write/fsync/rotate; queueMutex guards everything below.
+    mutex ioMutex;
+    mutex queueMutex;
+    condition_variable workAvailable;
+    condition_variable batchDurable;
+    condition_variable spaceAvailable;
+    QueuedFile files[2];
+    size_t queuedOps;
+    bool flushRequested;
+    bool failed;
+    bool stopping;
+    uint64_t flushes;
+    double lastFlushMillis;
+    thread ioThread;
+
+    QueuedFile& fileFor(PersistedFile which) {
+        return files[static_cast<int>(which)];
+    }
+
+    // Caller holds ioMutex.
+    void writeHeaderIfEmpty(QueuedFile& file) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            if (file.bytes > 0 || file.header.empty()) return;
+        }
+        if (!writeDescriptor(file.fd, file.header.data(), file.header.size()) ||
+            (file.syncOnFlush && !syncDescriptor(file.fd))) {
+            throw ReservationException("Unable to write file header.");
+        }
+        lock_guard<mutex> lock(queueMutex);
+        file.bytes = static_cast<long long>(file.header.size());
+    }
+
+    // Caller holds ioMutex.
+    void flushFile(QueuedFile& file) {
+        string batch;
+        uint64_t batchSeq;
+        {
+            lock_guard<mutex> lock(queueMutex);
+            if (file.pending.empty()) return;
+            batch.swap(file.pending);
+            queuedOps -= file.pendingOps;
+            file.pendingOps = 0;
+            batchSeq = file.appendedSeq;
+        }
+        spaceAvailable.notify_all();
+        auto start = chrono::steady_clock::now();
+        bool ok = file.fd >= 0 && writeDescriptor(file.fd, batch.data(), batch.size()) &&
+                  (!file.syncOnFlush || syncDescriptor(file.fd));
+        {
+            lock_guard<mutex> lock(queueMutex);
+            if (ok) {
+                file.durableSeq = batchSeq;
+                flushes++;
+                lastFlushMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            } else if (file.syncOnFlush) {
+                failed = true;
+            }
+        }
+        batchDurable.notify_all();
+        if (!ok) {
+            cerr << "Error: Unable to write to " << (file.syncOnFlush ? "reservations journal." : "log file.") << endl;
+        }
+    }
+
+    // Caller holds ioMutex.
+    void flushAll() {
+        for (auto& file : files) {
+            flushFile(file);
+        }
+    }
+
+    void runIoThread() {
+        unique_lock<mutex> lock(queueMutex);
+        while (!stopping) {
+            workAvailable.wait_for(lock, groupCommitWindow, [this] {
+                return stopping || flushRequested || queuedOps >= groupCommitOps;
+            });
+            flushRequested = false;
+            lock.unlock();
+            {
+                lock_guard<mutex> io(ioMutex);
+                flushAll();
+            }
+            lock.lock();
+        }
+    }
+
+public:
+    PersistenceQueue(DurabilityMode durability, int windowMillis, int maxBatchOps, int maxQueuedOps)
+        : mode(durability), groupCommitWindow(windowMillis), groupCommitOps(static_cast<size_t>(maxBatchOps)),
+          capacity(static_cast<size_t>(maxQueuedOps)), queuedOps(0), flushRequested(false), failed(false),
+          stopping(false), flushes(0), lastFlushMillis(0) {
+        ioThread = thread(&PersistenceQueue::runIoThread, this);
+    }
+
+    ~PersistenceQueue() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        workAvailable.notify_one();
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
+        lock_guard<mutex> io(ioMutex);
+        flushAll();
+        for (auto& file : files) {
+            if (file.fd >= 0) closeDescriptor(file.fd);
+        }
+    }
+
+    PersistenceQueue(const PersistenceQueue&) = delete;
+    PersistenceQueue& operator=(const PersistenceQueue&) = delete;
+
+    // header, if given, is written ahead of everything else in a new file,
+    // including the fresh file rotate() starts.
+    void open(PersistedFile which, const string& path, const string& header = "") {
+        lock_guard<mutex> io(ioMutex);
+        QueuedFile& file = fileFor(which);
+        file.fd = openAppendDescriptor(path);
+        if (file.fd < 0) {
+            throw ReservationException(which == PersistedFile::Journal ? "Unable to open reservations journal for writing."
+                                                                       : "Unable to open log file.");
+        }
+        file.syncOnFlush = which == PersistedFile::Journal;
+        file.header = header;
+        error_code ec;
+        uintmax_t size = filesystem::file_size(path, ec);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            file.bytes = ec ? 0 : static_cast<long long>(size);
+        }
+        writeHeaderIfEmpty(file);
+    }
+
+    // Queues one serialized line and returns its ticket. Blocks only while the
+    // queue is full, which means the disk has fallen a whole queue behind.
+    uint64_t append(PersistedFile which, const string& line) {
+        unique_lock<mutex> lock(queueMutex);
+        if (queuedOps >= capacity) {
+            flushRequested = true;
+            workAvailable.notify_one();
+            spaceAvailable.wait(lock, [this] { return queuedOps < capacity || failed; });
+        }
+        QueuedFile& file = fileFor(which);
+        if (failed && file.syncOnFlush) {
+            throw ReservationException("Unable to write to reservations journal.");
+        }
+        if (file.pending.empty()) {
+            file.oldestPending = chrono::steady_clock::now();
+        }
+        file.pending += line;
+        file.pendingOps++;
+        file.bytes += static_cast<long long>(line.size());
+        queuedOps++;
+        if (mode != DurabilityMode::SyncEveryOp && queuedOps >= groupCommitOps) {
+            workAvailable.notify_one();
+        }
+        return ++file.appendedSeq;
+    }
+
+    // Blocks until the journal record behind ticket is as durable as the mode promises.
+    void waitDurable(uint64_t ticket) {
+        if (mode == DurabilityMode::Async) {
+            return;
+        }
+        unique_lock<mutex> lock(queueMutex);
+        QueuedFile& journal = fileFor(PersistedFile::Journal);
+        if (mode == DurabilityMode::SyncEveryOp && journal.durableSeq < ticket) {
+            flushRequested = true;
+            workAvailable.notify_one();
+        }
+        batchDurable.wait(lock, [this, &journal, ticket] { return journal.durableSeq >= ticket || failed; });
+        if (journal.durableSeq < ticket) {
+            throw ReservationException("Unable to write to reservations journal.");
+        }
+    }
+
+    // Writes out everything queued so far, whatever the durability mode.
+    void flushNow() {
+        lock_guard<mutex> io(ioMutex);
+        flushAll();
+    }
+
+    // Flushes everything queued for the file, closes it, lets moveFiles rename it,
+    // then reopens path as a fresh, empty file.
+    template <typename MoveFiles>
+    void rotate(PersistedFile which, const string& path, MoveFiles moveFiles) {
+        lock_guard<mutex> io(ioMutex);
+        QueuedFile& file = fileFor(which);
+        flushFile(file);
+        if (file.fd >= 0) {
+            closeDescriptor(file.fd);
+        }
+        moveFiles();
+        file.fd = openAppendDescriptor(path);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            if (file.fd < 0) {
+                failed = true;
+                throw ReservationException("Unable to open reservations journal for writing.");
+            }
+            file.bytes = 0;
+        }
+        writeHeaderIfEmpty(file);
+    }
+
+    long long size(PersistedFile which) {
+        lock_guard<mutex> lock(queueMutex);
+        return fileFor(which).bytes;
+    }
+
+    PersistenceStats stats() {
+        lock_guard<mutex> lock(queueMutex);
+        PersistenceStats result;
+        result.queuedRecords = queuedOps;
+        result.capacity = capacity;
+        result.oldestQueuedMillis = 0;
+        auto now = chrono::steady_clock::now();
+        for (const auto& file : files) {
+            if (!file.pending.empty()) {
+                result.oldestQueuedMillis = max(result.oldestQueuedMillis,
+                                                chrono::duration<double, milli>(now - file.oldestPending).count());
+            }
+        }
+        const QueuedFile& journal = files[static_cast<int>(PersistedFile::Journal)];
+        result.unsyncedJournalRecords = journal.appendedSeq - journal.durableSeq;
+        result.lastFlushMillis = lastFlushMillis;
+        result.flushes = flushes;
+        return result;
+    }
+};
+
+// -------- Compaction --------
+// A checkpoint is also the store's compactor: it folds the journal into fresh
+// segment files, which drops cancellation tombstones (C records), the
+// reservations they killed and every superseded R/U record. Space amplification
+// is bytes on disk over the bytes the live reservations need in segment form.
+struct CompactionStats {
+    uint64_t runs = 0;
+    uint64_t foldedRecords = 0;     // journal records folded by the last run
+    uint64_t droppedTombstones = 0; // of which cancellations
+    long long bytesWritten = 0;     // segment bytes written by the last run
+    uint64_t archivedRecords = 0;   // reservations the last run moved to the archive
+    double amplificationBefore = 1.0;
+    double amplificationAfter = 1.0;
+    double lastMillis = 0;
+};
+
+double spaceAmplification(long long diskBytes, long long liveBytes) {
+    return liveBytes > 0 ? static_cast<double>(diskBytes) / liveBytes : 1.0;
+}
+
+// -------- Checkpoint History --------
+// Every checkpoint that writes something also keeps the store as it stood:
+//   history/checkpoint-<lsn>/      checkpoint.txt ("<lsn>|<unix millis>"), the
+//                                  manifest, and hard links to every segment plus
+//                                  archive/ with hard links to every archive file
+//   history/journal-<lsn>.journal  the rotated journal that checkpoint folded in
+// Segment, manifest and archive files are only ever replaced by rename, so a hard
+// link pins the old version for the cost of a directory entry. The newest
+// restoreHistory checkpoints are kept, with every journal written after the
+// oldest of them.
+const string HISTORY_DIR = "history";
+
+string historyPath(const string& prefix, long long lsn, const string& suffix) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s%020lld%s", prefix.c_str(), lsn, suffix.c_str());
+    return HISTORY_DIR + "/" + name;
+}
+
+string checkpointHistoryPath(long long lsn) {
+    return historyPath("checkpoint-", lsn, "");
+}
+
+string journalHistoryPath(long long lsn) {
+    return historyPath("journal-", lsn, ".journal");
+}
+
+// LSNs of the kept checkpoints (or journals), oldest first.
+vector<long long> historyLsns(const string& prefix, const string& suffix) {
+    vector<long long> lsns;
+    error_code ec;
+    for (filesystem::directory_iterator it(HISTORY_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        string name = it->path().filename().string();
+        long long lsn;
+        if (name.size() > prefix.size() + suffix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+            parseInteger(string_view(name).substr(prefix.size(), name.size() - prefix.size() - suffix.size()), lsn)) {
+            lsns.push_back(lsn);
+        }
+    }
+    sort(lsns.begin(), lsns.end());
+    return lsns;
+}
+
+void linkOrCopyFile(const filesystem::path& from, const filesystem::path& to) {
+    error_code ec;
+    filesystem::create_hard_link(from, to, ec);
+    if (ec) {
+        filesystem::copy_file(from, to, filesystem::copy_options::overwrite_existing);
+    }
+}
+
+// Pins the committed segments, manifest and archive as checkpoint snapshotLsn.
+// The directory is assembled under a temporary name and renamed into place.
+void recordCheckpointHistory(long long snapshotLsn, long long millis) {
+    const filesystem::path target = checkpointHistoryPath(snapshotLsn);
+    const filesystem::path temp = target.string() + ".tmp";
+    error_code ec;
+    filesystem::remove_all(temp, ec);
+    filesystem::create_directories(temp / ARCHIVE_DIR);
+    for (filesystem::directory_iterator it(SEGMENT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        string extension = it->path().extension().string();
+        if (extension == ".bin" || it->path() == filesystem::path(MANIFEST_FILE)) {
+            linkOrCopyFile(it->path(), temp / it->path().filename());
+        }
+    }
+    for (const auto& path : archiveFiles()) {
+        linkOrCopyFile(path, temp / ARCHIVE_DIR / filesystem::path(path).filename());
+    }
+    writeFileAtomically((temp / "checkpoint.txt").string(), to_string(snapshotLsn) + "|" + to_string(millis) + "\n");
+    filesystem::remove_all(target, ec);
+    filesystem::rename(temp, target);
+    syncDirectory(HISTORY_DIR);
+}
+
+// Moves the rotated journal, whose records end at snapshotLsn, into the history.
+void archiveRotatedJournal(long long snapshotLsn) {
+    error_code ec;
+    filesystem::create_directories(HISTORY_DIR, ec);
+    filesystem::rename(ROTATED_JOURNAL_FILE, journalHistoryPath(snapshotLsn), ec);
+    if (ec) {
+        filesystem::remove(ROTATED_JOURNAL_FILE, ec);
+    }
+}
+
+void pruneCheckpointHistory(size_t keep) {
+    vector<long long> checkpoints = historyLsns("checkpoint-", "");
+    error_code ec;
+    while (checkpoints.size() > keep) {
+        filesystem::remove_all(checkpointHistoryPath(checkpoints.front()), ec);
+        checkpoints.erase(checkpoints.begin());
+    }
+    // Replay from the oldest kept checkpoint only needs journals past it.
+    long long oldest = checkpoints.empty() ? LLONG_MAX : checkpoints.front();
+    for (long long lsn : historyLsns("journal-", ".journal")) {
+        if (lsn <= oldest) filesystem::remove(journalHistoryPath(lsn), ec);
+    }
+}
+
+// -------- Point-in-Time Restore --------
+// Rebuilds the store as of a target LSN or wall-clock time into a new directory:
+// the newest kept checkpoint at or before the target is linked in as the base and
+// the journal records after it are replayed up to the target. Only the segments
+// those records touch are decoded and rewritten; the rest stay hard links.
+struct RestoreTarget {
+    bool byLsn = true;
+    long long lsn = 0;
+    long long millis = 0;  // last millisecond included when restoring by time
+};
+
+struct RestoreStats {
+    long long baseLsn = 0;
+    long long baseMillis = 0;
+    long long restoredLsn = 0;
+    size_t replayedRecords = 0;
+    size_t linkedSegments = 0;
+    size_t rewrittenSegments = 0;
+    double replaySeconds = 0;
+    double seconds = 0;
+};
+
+// "<lsn>", or a local time "YYYY-MM-DD HH:MM[:SS]" ('T' may separate the two).
+bool parseRestoreTarget(string text, RestoreTarget& target) {
+    if (!text.empty() && all_of(text.begin(), text.end(), ::isdigit)) {
+        target.byLsn = true;
+        return parseInteger(text, target.lsn);
+    }
+    if (text.size() > 10 && text[10] == 'T') {
+        text[10] = ' ';
+    }
+    tm fields = {};
+    int second = 0;
+    if (sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &fields.tm_year, &fields.tm_mon, &fields.tm_mday, &fields.tm_hour,
+               &fields.tm_min, &second) < 5) {
+        return false;
+    }
+    fields.tm_year -= 1900;
+    fields.tm_mon -= 1;
+    fields.tm_sec = second;
+    fields.tm_isdst = -1;
+    time_t seconds = mktime(&fields);
+    if (seconds == static_cast<time_t>(-1)) {
+        return false;
+    }
+    target.byLsn = false;
+    target.millis = static_cast<long long>(seconds) * 1000 + 999;
+    return true;
+}
+
+string formatLocalTime(long long millis) {
+    time_t seconds = static_cast<time_t>(millis / 1000);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+    return buffer;
+}
+
+struct RestoreRecord {
+    long long lsn = 0;
+    char type = 'R';
+    long long id = -1;  // the reservation a U or C record replaces or removes
+    Reservation res;
+
+    RestoreRecord() : res(0, "", "", 0, "", "", -1) {}
+};
+
+bool parseRestoreRecord(string_view payload, RestoreRecord& record) {
+    string_view fields[10];
+    size_t first;
+    if (splitFieldViews(payload, '|', fields, 9) && fields[1] == "R") {
+        first = 2;
+    } else if (splitFieldViews(payload, '|', fields, 10) && fields[1] == "U") {
+        first = 3;
+        record.id = parseReservationIdOrInvalid(fields[2]);
+    } else if (splitFieldViews(payload, '|', fields, 3) && fields[1] == "C") {
+        record.type = 'C';
+        record.id = parseReservationIdOrInvalid(fields[2]);
+        return parseInteger(fields[0], record.lsn);
+    } else {
+        return false;
+    }
+    int partySize, tableNumber;
+    if (!parseInteger(fields[0], record.lsn) || !parseInteger(fields[first + 3], partySize) ||
+        !parseInteger(fields[first + 6], tableNumber)) {
+        return false;
+    }
+    record.type = fields[1][0];
+    record.res = Reservation(parseReservationIdOrInvalid(fields[first]), string(fields[first + 1]), string(fields[first + 2]), partySize,
+                             string(fields[first + 4]), string(fields[first + 5]), tableNumber);
+    return true;
+}
+
+// Calls visit(record) for each change journaled after fromLsn, up to the target,
+// in LSN order, and returns the LSN of the last record read.
+template <typename Visitor>
+long long replayJournals(const vector<string>& journals, long long fromLsn, const RestoreTarget& target,
+                         Visitor visit) {
+    long long lastLsn = fromLsn;
+    bool reachedTarget = false;
+    RestoreRecord record;
+    for (const auto& path : journals) {
+        MappedFile journal(path);
+        if (reachedTarget || !journal.isOpen()) continue;
+        scanJournal(journal.data(), journal.size(), [&](string_view payload) {
+            if (checkFormatHeader(payload, JOURNAL_TAG, JOURNAL_FORMAT_VERSION)) {
+                return true;
+            }
+            string_view fields[3];
+            long long lsn, millis;
+            if (!splitFieldViews(payload.substr(0, payload.find('|', payload.find('|') + 1)), '|', fields, 2) ||
+                !parseInteger(fields[0], lsn)) {
+                cerr << "Error: Skipping malformed record in " << path << ": " << payload << endl;
+                return true;
+            }
+            if (lsn <= lastLsn) {
+                return true;
+            }
+            if (target.byLsn && lsn > target.lsn) {
+                reachedTarget = true;
+                return false;
+            }
+            if (fields[1] == "T") {
+                if (splitFieldViews(payload, '|', fields, 3) && parseInteger(fields[2], millis) && !target.byLsn &&
+                    millis > target.millis) {
+                    reachedTarget = true;
+                    return false;
+                }
+            } else {
+                // Skipped as startup skips it, so the restore matches what the store served.
+                record = RestoreRecord();
+                if (parseRestoreRecord(payload, record)) {
+                    visit(record);
+                } else {
+                    cerr << "Error: Skipping malformed record in " << path << ": " << payload << endl;
+                }
+            }
+            lastLsn = lsn;
+            return true;
+        });
+    }
+    return lastLsn;
+}
+
+RestoreStats restoreToPointInTime(const RestoreTarget& target, const string& intoDir) {
+    auto start = chrono::steady_clock::now();
+    RestoreStats stats;
+    error_code ec;
+    if (filesystem::exists(intoDir) && !filesystem::is_empty(intoDir, ec)) {
+        throw ReservationException(intoDir + " already exists and is not empty.");
+    }
+
+    // Base: the newest kept checkpoint at or before the target.
+    bool haveBase = false;
+    for (long long lsn : historyLsns("checkpoint-", "")) {
+        ifstream info(checkpointHistoryPath(lsn) + "/checkpoint.txt");
+        long long savedLsn, millis;
+        char bar;
+        if (!(info >> savedLsn >> bar >> millis) || (target.byLsn ? lsn > target.lsn : millis > target.millis)) {
+            continue;
+        }
+        haveBase = true;
+        stats.baseLsn = lsn;
+        stats.baseMillis = millis;
+    }
+    if (!haveBase) {
+        throw ReservationException("No kept checkpoint is at or before the target.");
+    }
+    const filesystem::path base = checkpointHistoryPath(stats.baseLsn);
+    map<string, string> manifestLines;
+    long long nextId = 1;
+    {
+        ifstream manifest((base / filesystem::path(MANIFEST_FILE).filename()).string());
+        string line;
+        while (getline(manifest, line)) {
+            if (checkFormatHeader(line, MANIFEST_TAG, MANIFEST_FORMAT_VERSION)) continue;
+            string_view fields[3];
+            if (splitFieldViews(line, '|', fields, 3)) {
+                manifestLines[string(fields[0])] = line;
+            } else if (splitFieldViews(line, '|', fields, 2)) {
+                parseInteger(fields[1], nextId);
+            }
+        }
+    }
+
+    // Journal records after the base, up to the target. The first pass keeps only
+    // each changed ID's last LSN and whether it survives; the second spills the
+    // surviving copies into their dates. Neither holds the records themselves.
+    vector<string> journals;
+    for (long long lsn : historyLsns("journal-", ".journal")) {
+        if (lsn > stats.baseLsn) journals.push_back(journalHistoryPath(lsn));
+    }
+    journals.push_back(ROTATED_JOURNAL_FILE);
+    journals.push_back(JOURNAL_FILE);
+    struct LastChange {
+        long long lsn;
+        bool live;
+    };
+    unordered_map<long long, LastChange> changed;
+    auto replayStart = chrono::steady_clock::now();
+    stats.restoredLsn = replayJournals(journals, stats.baseLsn, target, [&](const RestoreRecord& record) {
+        if (record.type != 'R') changed[record.id] = LastChange{record.lsn, false};
+        if (record.type != 'C') {
+            changed[record.res.id] = LastChange{record.lsn, true};
+            if (record.res.id < LLONG_MAX) nextId = max(nextId, record.res.id + 1);
+        }
+        stats.replayedRecords++;
+    });
+
+    const filesystem::path into(intoDir);
+    filesystem::create_directories(into / SEGMENT_DIR);
+    filesystem::create_directories(into / ARCHIVE_DIR);
+    SegmentSpiller spiller(intoDir + "/");
+    RestoreTarget restored;
+    restored.lsn = stats.restoredLsn;
+    replayJournals(journals, stats.baseLsn, restored, [&](const RestoreRecord& record) {
+        if (record.type == 'C') return;
+        auto last = changed.find(record.res.id);
+        if (last != changed.end() && last->second.live && last->second.lsn == record.lsn) spiller.add(record.res);
+    });
+
+    // Base segments holding a changed ID are rewritten without their old copies;
+    // the rest, and the archive, are linked. Legacy records without a parsable ID
+    // cannot be named by the journal, so they are carried over as they are.
+    string manifest = manifestHeader(stats.restoredLsn, nextId);
+    for (const auto& entry : manifestLines) {
+        MappedFile file((base / (entry.first + ".bin")).string());
+        if (!file.isOpen()) {
+            throw ReservationException("Unable to open checkpoint segment " + entry.first + ".");
+        }
+        bool touched = false;
+        if (!changed.empty()) {
+            BinarySnapshotView view(file);
+            for (size_t i = 0; i < view.size() && !touched; ++i) {
+                touched = changed.count(view.id(i)) > 0;
+            }
+        }
+        if (!touched && !spiller.holds(entry.first)) {
+            linkOrCopyFile(base / (entry.first + ".bin"), into / segmentPath(entry.first));
+            manifest += entry.second + "\n";
+            stats.linkedSegments++;
+            continue;
+        }
+        readBinarySnapshot(file, [&](const Reservation& res) {
+            if (res.id < 0 || !changed.count(res.id)) spiller.add(res);
+        });
+    }
+    stats.replaySeconds = chrono::duration<double>(chrono::steady_clock::now() - replayStart).count();
+    manifest += spiller.finish(stats.restoredLsn, stats.rewrittenSegments);
+    for (filesystem::directory_iterator it(base / ARCHIVE_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        linkOrCopyFile(it->path(), into / ARCHIVE_DIR / it->path().filename());
+    }
+    writeFileAtomically((into / MANIFEST_FILE).string(), manifest);
+    // Accounts are not versioned, so the restored store gets a copy of the current
+    // file rather than the accounts as of the target; see the --restore-at output.
+    // The log is appended in place, so it is copied rather than linked.
+    if (filesystem::exists("customer_accounts.txt")) {
+        filesystem::copy_file("customer_accounts.txt", into / "customer_accounts.txt");
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// -------- Online Backup --------
+// A backup is a complete store directory as of one LSN, written while the program
+// keeps serving. Segment, manifest and archive files are copy-on-write already
+// (a checkpoint writes a new file and renames it over the old one), so holding off
+// checkpoints pins a consistent set of them; everything newer is in the journal,
+// which is append-only and copied up to the captured LSN. Writers only ever wait
+// for the instant it takes to read that LSN. Copies are paced by the compaction
+// throttle so they do not compete with journal fsyncs.
+// The backup directory also gets backup.txt ("<lsn>|<unix millis>").
+const size_t BACKUP_COPY_CHUNK_BYTES = 1 << 20;
+
+struct BackupStatus {
+    bool running = false;
+    bool succeeded = false;
+    string path;
+    long long lsn = 0;
+    long long bytesCopied = 0;
+    size_t files = 0;
+    double seconds = 0;
+    string error;
+};
+
+// Copies the first `bytes` bytes of data to path and fsyncs it.
+void writeBackupFile(const string& path, const char* data, size_t bytes, IoThrottle& throttle) {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        throw ReservationException("Unable to open " + path + " for writing.");
+    }
+    for (size_t offset = 0; offset < bytes; offset += BACKUP_COPY_CHUNK_BYTES) {
+        size_t length = min(BACKUP_COPY_CHUNK_BYTES, bytes - offset);
+        out.write(data + offset, static_cast<streamsize>(length));
+        throttle.consume(static_cast<long long>(length));
+    }
+    out.close();
+    if (!out || !syncFile(path)) {
+        throw ReservationException("Unable to write " + path + ".");
+    }
+}
+
+// Maps a file as it is now, or returns null when it does not exist. The mapping
+// keeps that version readable even once the file is replaced or removed.
+unique_ptr<MappedFile> pinFile(const string& path) {
+    if (!filesystem::exists(path)) {
+        return nullptr;
+    }
+    unique_ptr<MappedFile> file(new MappedFile(path));
+    if (!file->isOpen() && fileBytes(path) > 0) {
+        throw ReservationException("Unable to open " + path + " for reading.");
+    }
+    return file;
+}
+
+// Backs up one pinned file. Returns bytes copied.
+long long backupFile(const MappedFile& file, const string& to, IoThrottle& throttle, size_t& files) {
+    writeBackupFile(to, file.isOpen() ? file.data() : "", file.size(), throttle);
+    files++;
+    return static_cast<long long>(file.size());
+}
+
+// Length of the journal prefix holding every record up to lsn.
+size_t journalPrefixThrough(const MappedFile& journal, long long lsn) {
+    return scanJournal(journal.data(), journal.size(), [lsn](string_view payload) {
+        if (checkFormatHeader(payload, JOURNAL_TAG, JOURNAL_FORMAT_VERSION)) {
+            return true;
+        }
+        long long recordLsn;
+        return parseInteger(payload.substr(0, payload.find('|')), recordLsn) && recordLsn <= lsn;
+    });
+}
+
+// -------- Journal Follower --------
+// A follower is a second process on the same store that serves reads only. It
+// loads the manifest and active segments like a primary would, then keeps the
+// primary's journal open and applies whatever was appended every
+// followerPollMillis. When the primary checkpoints, its journal is renamed away
+// and a new one started; the follower drains the old file through its open
+// handle, waits until the manifest covers everything it applied, and reloads from
+// the new checkpoint. It never writes to the store.
+struct FollowerStatus {
+    long long appliedLsn = 0;
+    long long primaryClockMillis = 0;  // newest primary clock record applied
+    long long lagMillis = 0;           // time since the follower last had nothing left to apply
+    long long bytesBehind = 0;
+    bool awaitingCheckpoint = false;
+};
+
+// LSN of the first record in a journal, or -1 if it has none yet.
+long long firstJournalRecordLsn(const string& path) {
+    ifstream file(path, ios::binary);
+    char buffer[512];
+    file.read(buffer, sizeof(buffer));
+    long long lsn = -1;
+    scanJournal(buffer, static_cast<size_t>(file.gcount()), [&lsn](string_view payload) {
+        if (checkFormatHeader(payload, JOURNAL_TAG, JOURNAL_FORMAT_VERSION)) {
+            return true;
+        }
+        parseInteger(payload.substr(0, payload.find('|')), lsn);
+        return false;
+    });
+    return lsn;
+}
+
+long long manifestSnapshotLsn() {
+    ifstream manifest(MANIFEST_FILE);
+    string line;
+    long long lsn = 0;
+    if (getline(manifest, line) && checkFormatHeader(line, MANIFEST_TAG, MANIFEST_FORMAT_VERSION)) {
+        getline(manifest, line);
+    }
+    parseInteger(string_view(line).substr(0, line.find('|')), lsn);
+    return lsn;
+}
+
+// -------- Storage Engines --------
+// The alternatives to the journal backend. ReservationManager keeps the whole store
+// resident with these and hands each change over in its journal form ("R|<fields>",
+// "U|<old id>|<fields>" or "C|<id>"); commit() then ends the operation once, however
+// many records it produced. The journal backend is not an engine: its segments,
+// checkpoints and journal are built into ReservationManager itself.
+//
+// Each engine has its own files. The text and binary engines use the legacy store
+// layout, so switching back to the journal backend migrates what they wrote.
+class StorageEngine {
+public:
+    virtual ~StorageEngine() {}
+    virtual string name() const = 0;
+    // Calls add for every stored reservation; returns the saved next ID number (0 if none).
+    virtual long long load(const function<void(Reservation&&)>& add) = 0;
+    virtual void record(const string& change) = 0;
+    // all is the whole store after the operation's changes.
+    virtual void commit(const vector<Reservation>& all, long long nextId) = 0;
+    virtual long long diskBytes() const = 0;
+};
+
+class MemoryStorageEngine : public StorageEngine {
+public:
+    string name() const override { return "memory"; }
+    long long load(const function<void(Reservation&&)>&) override { return 0; }
+    void record(const string&) override {}
+    void commit(const vector<Reservation>&, long long) override {}
+    long long diskBytes() const override { return 0; }
+};
+
+long long readNextIdFile() {
+    ifstream idFile("next_id.txt");
+    long long savedId = 0;
+    idFile >> savedId;
+    return savedId;
+}
+
+// Rewrites the store on every operation and fsyncs it, whatever the durability
+// mode: the cost of an operation grows with the store.
+class WholeStoreEngine : public StorageEngine {
+    bool changed = false;
+
+protected:
+    virtual void write(const vector<Reservation>& all) = 0;
+
+public:
+    void record(const string&) override { changed = true; }
+    void commit(const vector<Reservation>& all, long long nextId) override {
+        if (!changed) {
+            return;
+        }
+        write(all);
+        writeFileAtomically("next_id.txt", to_string(nextId) + "\n");
+        changed = false;
+    }
+};
+
+class LegacyTextStorageEngine : public WholeStoreEngine {
+protected:
+    void write(const vector<Reservation>& all) override {
+        string contents;
+        for (const auto& res : all) {
+            contents.append(formatReservationFields(res)).append(1, '\n');
+        }
+        writeFileAtomically("reservations.txt", contents);
+    }
+
+public:
+    string name() const override { return "text"; }
+    long long load(const function<void(Reservation&&)>& add) override {
+        MappedFile file("reservations.txt");
+        if (file.isOpen()) {
+            for (auto& res : parseLegacyReservations(file.data(), file.size())) {
+                add(move(res));
+            }
+        }
+        return readNextIdFile();
+    }
+    long long diskBytes() const override { return fileBytes("reservations.txt") + fileBytes("next_id.txt"); }
+};
+
+class BinarySnapshotStorageEngine : public WholeStoreEngine {
+protected:
+    void write(const vector<Reservation>& all) override {
+        writeBinarySnapshot(SNAPSHOT_FILE + ".tmp", all, 0);
+        commitFile(SNAPSHOT_FILE + ".tmp", SNAPSHOT_FILE);
+    }
+
+public:
+    string name() const override { return "binary"; }
+    long long load(const function<void(Reservation&&)>& add) override {
+        MappedFile file(SNAPSHOT_FILE);
+        if (file.isOpen()) {
+            readBinarySnapshot(file, [&add](const Reservation& res) { add(Reservation(res)); });
+        }
+        return readNextIdFile();
+    }
+    long long diskBytes() const override { return fileBytes(SNAPSHOT_FILE) + fileBytes("next_id.txt"); }
+};
+
+#ifdef HAVE_SQLITE3
+// One row per reservation in reservations.db. Each operation is one transaction;
+// the durability mode picks how often SQLite fsyncs its write-ahead log.
+class SqliteStorageEngine : public StorageEngine {
+    const string path = "reservations.db";
+    sqlite3* db = nullptr;
+    sqlite3_stmt* insertRow = nullptr;
+    sqlite3_stmt* deleteRow = nullptr;
+    sqlite3_stmt* saveNextId = nullptr;
+    bool inTransaction = false;
+
+    [[noreturn]] void fail(const string& action) const {
+        throw ReservationException("SQLite could not " + action + ": " + (db ? sqlite3_errmsg(db) : "out of memory"));
+    }
+
+    void exec(const char* sql) {
+        if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK) fail(string("run ") + sql);
+    }
+
+    sqlite3_stmt* prepare(const char* sql) {
+        sqlite3_stmt* statement = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &statement, nullptr) != SQLITE_OK) fail("prepare a statement");
+        return statement;
+    }
+
+    void run(sqlite3_stmt* statement) {
+        int status = sqlite3_step(statement);
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+        if (status != SQLITE_DONE) fail("write " + path);
+    }
+
+    void bindText(sqlite3_stmt* statement, int index, const string& value) {
+        sqlite3_bind_text(statement, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    }
+
+    // fields[first..first+6] are a reservation in journal order, with its party size
+    // and table number already parsed by record().
+    void insert(const vector<string>& fields, size_t first, int partySize, int tableNumber) {
+        for (int i = 0; i < 7; ++i) {
+            if (i == 3) {
+                sqlite3_bind_int(insertRow, i + 1, partySize);
+            } else if (i == 6) {
+                sqlite3_bind_int(insertRow, i + 1, tableNumber);
+            } else {
+                bindText(insertRow, i + 1, fields[first + i]);
+            }
+        }
+        run(insertRow);
+    }
+
+    void remove(const string& id) {
+        bindText(deleteRow, 1, id);
+        run(deleteRow);
+    }
+
+public:
+    SqliteStorageEngine() {
+        if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) fail("open " + path);
+        exec("PRAGMA journal_mode=WAL");
+        switch (storageConfig.durability) {
+            case DurabilityMode::SyncEveryOp: exec("PRAGMA synchronous=FULL"); break;
+            case DurabilityMode::GroupCommit: exec("PRAGMA synchronous=NORMAL"); break;
+            case DurabilityMode::Async: exec("PRAGMA synchronous=OFF"); break;
+        }
+        exec("CREATE TABLE IF NOT EXISTS reservations (id TEXT PRIMARY KEY, customer TEXT NOT NULL, "
+             "phone TEXT NOT NULL, party INTEGER NOT NULL, date TEXT NOT NULL, time TEXT NOT NULL, "
+             "table_number INTEGER NOT NULL) WITHOUT ROWID");
+        exec("CREATE TABLE IF NOT EXISTS settings (name TEXT PRIMARY KEY, value INTEGER NOT NULL)");
+        insertRow = prepare("INSERT OR REPLACE INTO reservations VALUES (?, ?, ?, ?, ?, ?, ?)");
+        deleteRow = prepare("DELETE FROM reservations WHERE id = ?");
+        saveNextId = prepare("INSERT OR REPLACE INTO settings VALUES ('next_id', ?)");
+    }
+
+    ~SqliteStorageEngine() override {
+        if (inTransaction) sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        sqlite3_finalize(insertRow);
+        sqlite3_finalize(deleteRow);
+        sqlite3_finalize(saveNextId);
+        sqlite3_close(db);
+    }
+
+    string name() const override { return "sqlite"; }
+
+    long long load(const function<void(Reservation&&)>& add) override {
+        sqlite3_stmt* rows = prepare("SELECT id, customer, phone, party, date, time, table_number FROM reservations");
+        auto text = [rows](int column) { return string(reinterpret_cast<const char*>(sqlite3_column_text(rows, column))); };
+        while (sqlite3_step(rows) == SQLITE_ROW) {
+            add(Reservation(parseReservationIdOrInvalid(text(0)), text(1), text(2), sqlite3_column_int(rows, 3),
+                            text(4), text(5), sqlite3_column_int(rows, 6)));
+        }
+        sqlite3_finalize(rows);
+        sqlite3_stmt* nextId = prepare("SELECT value FROM settings WHERE name = 'next_id'");
+        long long savedId = sqlite3_step(nextId) == SQLITE_ROW ? sqlite3_column_int64(nextId, 0) : 0;
+        sqlite3_finalize(nextId);
+        return savedId;
+    }
+
+    // A reservation whose numbers do not parse is refused before anything is written.
+    void record(const string& change) override {
+        vector<string> fields = splitFields(change, '|');
+        bool reserve = fields[0] == "R" && fields.size() == 8;
+        bool update = fields[0] == "U" && fields.size() == 9;
+        size_t first = update ? 2 : 1;
+        int partySize = 0, tableNumber = 0;
+        if ((reserve || update) &&
+            (!parseInteger(fields[first + 3], partySize) || !parseInteger(fields[first + 6], tableNumber))) {
+            throw ReservationException("SQLite could not store a malformed change: " + change);
+        }
+        if (!inTransaction) {
+            exec("BEGIN");
+            inTransaction = true;
+        }
+        if (reserve) {
+            insert(fields, first, partySize, tableNumber);
+        } else if (update) {
+            remove(fields[1]);
+            insert(fields, first, partySize, tableNumber);
+        } else if (fields[0] == "C" && fields.size() == 2) {
+            remove(fields[1]);
+        }
+    }
+
+    void commit(const vector<Reservation>&, long long nextId) override {
+        if (!inTransaction) {
+            return;
+        }
+        sqlite3_bind_int64(saveNextId, 1, nextId);
+        run(saveNextId);
+        exec("COMMIT");
+        inTransaction = false;
+    }
+
+    long long diskBytes() const override { return fileBytes(path) + fileBytes(path + "-wal"); }
+};
+#endif
+
+// Null for the journal backend.
+unique_ptr<StorageEngine> createStorageEngine(StorageBackend backend) {
+    switch (backend) {
+        case StorageBackend::Journal: return nullptr;
+        case StorageBackend::Memory: return unique_ptr<StorageEngine>(new MemoryStorageEngine());
+        case StorageBackend::LegacyText: return unique_ptr<StorageEngine>(new LegacyTextStorageEngine());
+        case StorageBackend::BinarySnapshot: return unique_ptr<StorageEngine>(new BinarySnapshotStorageEngine());
+        case StorageBackend::Sqlite:
+#ifdef HAVE_SQLITE3
+            return unique_ptr<StorageEngine>(new SqliteStorageEngine());
+#else
+            break;
+#endif
+    }
+    throw ReservationException("The " + storageBackendName(backend) + " storage backend is not built in.");
+}
+
+// -------- Reservation ID Index --------
+// Open-addressing hash table (linear probing) from a reservation ID to its slot in
+// ReservationManager's resident vector. An entry holds the ID and the slot, so a
+// lookup never touches the reservations themselves. The mutators are given the
+// slot they affect and match on ID and slot, which keeps legacy records that share
+// the invalid ID -1 apart. Erasing shifts later entries back, so no tombstones build up.
+class ReservationIdIndex {
+    static const uint32_t EMPTY = UINT32_MAX;
+    struct Entry {
+        long long id;
+        uint32_t slot;
+    };
+    vector<Entry> entries;  // size is zero or a power of two
+    size_t count = 0;
+
+    // IDs are handed out sequentially; the multiply spreads runs of them anyway.
+    size_t home(long long id) const {
+        return static_cast<size_t>((static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ULL) >> 32) & (entries.size() - 1);
+    }
+
+    void place(long long id, uint32_t slot) {
+        size_t i = home(id);
+        while (entries[i].slot != EMPTY) {
+            i = (i + 1) & (entries.size() - 1);
+        }
+        entries[i] = {id, slot};
+    }
+
+    // Position of the entry for (id, slot); the entry must exist.
+    size_t position(long long id, size_t slot) const {
+        size_t i = home(id);
+        while (entries[i].id != id || entries[i].slot != slot) {
+            i = (i + 1) & (entries.size() - 1);
+        }
+        return i;
+    }
+
+    void grow() {
+        vector<Entry> old(max<size_t>(16, entries.size() * 2), Entry{0, EMPTY});
+        old.swap(entries);
+        for (const auto& entry : old) {
+            if (entry.slot != EMPTY) place(entry.id, entry.slot);
+        }
+    }
+
+public:
+    // Slot holding id, or -1.
+    int find(long long id) const {
+        if (count == 0) {
+            return -1;
+        }
+        for (size_t i = home(id); entries[i].slot != EMPTY; i = (i + 1) & (entries.size() - 1)) {
+            if (entries[i].id == id) {
+                return static_cast<int>(entries[i].slot);
+            }
+        }
+        return -1;
+    }
+
+    // id must not be indexed already (legacy -1 IDs excepted).
+    void insert(long long id, size_t slot) {
+        if ((count + 1) * 10 > entries.size() * 7) {
+            grow();
+        }
+        place(id, static_cast<uint32_t>(slot));
+        count++;
+    }
+
+    void erase(long long id, size_t slot) {
+        size_t mask = entries.size() - 1;
+        size_t hole = position(id, slot);
+        for (size_t i = (hole + 1) & mask; entries[i].slot != EMPTY; i = (i + 1) & mask) {
+            // An entry may fill the hole only if its home is not in (hole, i].
+            size_t entryHome = home(entries[i].id);
+            bool movable = hole < i ? (entryHome <= hole || entryHome > i) : (entryHome <= hole && entryHome > i);
+            if (movable) {
+                entries[hole] = entries[i];
+                hole = i;
+            }
+        }
+        entries[hole].slot = EMPTY;
+        count--;
+    }
+
+    // The reservation id moved from slot `from` to slot `to`.
+    void relocate(long long id, size_t from, size_t to) { entries[position(id, from)].slot = static_cast<uint32_t>(to); }
+
+    void rebuild(const vector<Reservation>& rows) {
+        clear();
+        for (size_t i = 0; i < rows.size(); ++i) {
+            insert(rows[i].id, i);
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        count = 0;
+    }
+
+    size_t memoryBytes() const { return entries.capacity() * sizeof(Entry); }
+};
+
+// ID -> the unloaded segment holding it, so looking up an ID that is not resident,
+// or one that does not exist, costs a hash probe instead of a pass over every
+// segment file. The manager lists a segment's IDs when it evicts it, drops them when
+// it loads it, and lists segments it has never loaded on the first lookup, as it
+// does for the secondary indexes. Legacy -1 IDs are never looked up, so never listed.
+class UnloadedIdIndex {
+    ReservationIdIndex ids;  // ID -> segment number
+    unordered_map<string, uint32_t> numbers;
+    vector<string> keys;  // by segment number
+
+public:
+    // Key of the segment holding id, or "".
+    string find(long long id) const {
+        int number = id < 0 ? -1 : ids.find(id);
+        return number < 0 ? "" : keys[number];
+    }
+
+    void add(long long id, const string& key) {
+        if (id < 0) {
+            return;
+        }
+        auto inserted = numbers.emplace(key, static_cast<uint32_t>(keys.size()));
+        if (inserted.second) keys.push_back(key);
+        if (ids.find(id) != static_cast<int>(inserted.first->second)) ids.insert(id, inserted.first->second);
+    }
+
+    void remove(long long id, const string& key) {
+        auto number = numbers.find(key);
+        if (id >= 0 && number != numbers.end() && ids.find(id) == static_cast<int>(number->second)) {
+            ids.erase(id, number->second);
+        }
+    }
+
+    void clear() {
+        ids.clear();
+        numbers.clear();
+        keys.clear();
+    }
+
+    size_t memoryBytes() const { return ids.memoryBytes(); }
+};
+
+// -------- Secondary Indexes --------
+// A value (customer name, packed phone number) -> the reservations holding it, so a
+// lookup costs the matching bookings instead of a pass over the store. Each distinct
+// value is interned to a dense key once. Resident reservations are listed by slot in
+// ReservationManager's vector and kept in step by the resident helpers, as with
+// ReservationIdIndex. Reservations in segments that are not loaded are listed by
+// segment and record number: a segment file does not change while it is unloaded,
+// so the manager adds a segment's records when it evicts it, drops them when it
+// loads it, and lists segments it has never loaded on the first lookup.
+template <typename Value>
+class SecondaryIndex {
+public:
+    struct UnloadedBooking {
+        uint32_t segment;  // see segmentKey()
+        uint32_t record;   // position in the segment file
+    };
+
+private:
+    struct Bookings {
+        vector<uint32_t> slots;            // resident, in the order they became resident
+        vector<UnloadedBooking> unloaded;  // in (segment key, record) order
+    };
+    unordered_map<Value, uint32_t> keys;  // only values with something listed
+    vector<Bookings> bookings;             // by key
+    vector<uint32_t> freeKeys;             // keys of dropped values, reused first
+    unordered_map<string, uint32_t> segmentIds;
+    vector<string> segmentKeys;  // by segment id
+
+    Bookings& bookingsFor(const Value& value) {
+        auto inserted = keys.emplace(value, 0);
+        if (inserted.second) {
+            if (freeKeys.empty()) {
+                inserted.first->second = static_cast<uint32_t>(bookings.size());
+                bookings.emplace_back();
+            } else {
+                inserted.first->second = freeKeys.back();
+                freeKeys.pop_back();
+            }
+        }
+        return bookings[inserted.first->second];
+    }
+
+    // Forgets the value at it once nothing is listed under it. Returns the next entry.
+    typename unordered_map<Value, uint32_t>::iterator dropIfEmpty(typename unordered_map<Value, uint32_t>::iterator it) {
+        Bookings& entry = bookings[it->second];
+        if (!entry.slots.empty() || !entry.unloaded.empty()) {
+            return ++it;
+        }
+        entry = Bookings();  // gives the lists' memory back
+        freeKeys.push_back(it->second);
+        return keys.erase(it);
+    }
+
+    // Where slot is listed under value. Throws when it is not: the index has drifted
+    // from the reservations it describes.
+    vector<uint32_t>::iterator listedSlot(const Value& value, size_t slot) {
+        auto key = keys.find(value);
+        if (key != keys.end()) {
+            vector<uint32_t>& slots = bookings[key->second].slots;
+            auto it = std::find(slots.begin(), slots.end(), static_cast<uint32_t>(slot));
+            if (it != slots.end()) return it;
+        }
+        throw ReservationException("Secondary index is out of step with the reservations.");
+    }
+
+    // Where (segmentKey, record) is or belongs in list.
+    typename vector<UnloadedBooking>::iterator position(vector<UnloadedBooking>& list, const string& key,
+                                                        uint32_t record) {
+        return lower_bound(list.begin(), list.end(), record, [&](const UnloadedBooking& booking, uint32_t target) {
+            const string& bookingKey = segmentKeys[booking.segment];
+            return bookingKey != key ? bookingKey < key : booking.record < target;
+        });
+    }
+
+public:
+    // Key for value, or -1 when nothing is listed under it.
+    int find(const Value& value) const {
+        auto it = keys.find(value);
+        return it == keys.end() ? -1 : static_cast<int>(it->second);
+    }
+
+    const vector<uint32_t>& slots(int key) const { return bookings[key].slots; }
+    const vector<UnloadedBooking>& unloaded(int key) const { return bookings[key].unloaded; }
+    const string& segmentKey(uint32_t segment) const { return segmentKeys[segment]; }
+
+    // Whether anything is listed under value.
+    bool contains(const Value& value) const { return find(value) >= 0; }
+
+    void insert(const Value& value, size_t slot) { bookingsFor(value).slots.push_back(static_cast<uint32_t>(slot)); }
+
+    void erase(const Value& value, size_t slot) {
+        auto it = listedSlot(value, slot);
+        auto key = keys.find(value);
+        bookings[key->second].slots.erase(it);
+        dropIfEmpty(key);
+    }
+
+    // The reservation moved from slot `from` to slot `to`.
+    void relocate(const Value& value, size_t from, size_t to) { *listedSlot(value, from) = static_cast<uint32_t>(to); }
+
+    void addUnloaded(const Value& value, const string& segmentKey, size_t record) {
+        auto inserted = segmentIds.emplace(segmentKey, static_cast<uint32_t>(segmentKeys.size()));
+        if (inserted.second) segmentKeys.push_back(segmentKey);
+        vector<UnloadedBooking>& list = bookingsFor(value).unloaded;
+        auto it = position(list, segmentKey, static_cast<uint32_t>(record));
+        if (it == list.end() || it->segment != inserted.first->second || it->record != record) {
+            list.insert(it, UnloadedBooking{inserted.first->second, static_cast<uint32_t>(record)});
+        }
+    }
+
+    void removeUnloaded(const Value& value, const string& segmentKey, size_t record) {
+        auto segment = segmentIds.find(segmentKey);
+        auto key = keys.find(value);
+        if (segment == segmentIds.end() || key == keys.end()) {
+            return;
+        }
+        vector<UnloadedBooking>& list = bookings[key->second].unloaded;
+        auto it = position(list, segmentKey, static_cast<uint32_t>(record));
+        if (it != list.end() && it->segment == segment->second && it->record == record) {
+            list.erase(it);
+            dropIfEmpty(key);
+        }
+    }
+
+    // Relists the resident reservations, valueOf giving each one's value; the
+    // unloaded ones are left alone.
+    template <typename ValueOf>
+    void rebuild(const vector<Reservation>& rows, ValueOf valueOf) {
+        for (auto& entry : bookings) {
+            entry.slots.clear();
+        }
+        for (size_t i = 0; i < rows.size(); ++i) {
+            insert(valueOf(rows[i]), i);
+        }
+        for (auto it = keys.begin(); it != keys.end();) {
+            it = dropIfEmpty(it);
+        }
+    }
+
+    void clear() {
+        keys.clear();
+        bookings.clear();
+        freeKeys.clear();
+        segmentIds.clear();
+        segmentKeys.clear();
+    }
+
+    // Heap held by the index, counting each hash node as its payload and two pointers.
+    size_t memoryBytes() const {
+        size_t bytes = keys.bucket_count() * sizeof(void*) +
+                       keys.size() * (sizeof(pair<Value, uint32_t>) + 2 * sizeof(void*)) +
+                       bookings.capacity() * sizeof(Bookings) + freeKeys.capacity() * sizeof(uint32_t);
+        for (const auto& entry : bookings) {
+            bytes += entry.slots.capacity() * sizeof(uint32_t) + entry.unloaded.capacity() * sizeof(UnloadedBooking);
+        }
+        return bytes;
+    }
+};
+
+using CustomerIndex = SecondaryIndex<string>;
+using PhoneIndex = SecondaryIndex<uint64_t>;
+
+// -------- Time Index --------
+// Resident reservations ordered by packReservationTime, so a date range costs a
+// binary search plus the reservations inside it. Entries are kept in one sorted
+// vector. Inserts go to a small sorted batch that range queries read alongside it
+// and that is merged in once it fills; erased entries are marked dead and swept out
+// once they are a quarter of the vector. Neither shifts the whole vector on every
+// change.
+class TimeIndex {
+    struct Entry {
+        uint32_t when;  // packReservationTime
+        uint32_t slot;  // position in ReservationManager's vector, or DEAD
+    };
+    static const uint32_t DEAD = UINT32_MAX;
+    static const size_t BATCH = 4096;
+    vector<Entry> sorted;   // by when; ties in the order they were inserted
+    vector<Entry> pending;  // inserted since the last merge, also by when
+    size_t dead = 0;
+
+    static bool earlier(const Entry& a, const Entry& b) { return a.when < b.when; }
+
+    // The entry for (when, slot) in entries, or end().
+    static vector<Entry>::iterator locate(vector<Entry>& entries, uint32_t when, size_t slot) {
+        auto it = lower_bound(entries.begin(), entries.end(), Entry{when, 0}, earlier);
+        while (it != entries.end() && it->when == when && it->slot != slot) ++it;
+        return it != entries.end() && it->when == when ? it : entries.end();
+    }
+
+    // The entry for (when, slot) in the batch or the sorted vector. Throws when there
+    // is none: the index has drifted from the reservations it describes.
+    vector<Entry>::iterator listed(uint32_t when, size_t slot) {
+        auto it = locate(pending, when, slot);
+        if (it != pending.end()) return it;
+        it = locate(sorted, when, slot);
+        if (it != sorted.end()) return it;
+        throw ReservationException("Time index is out of step with the reservations.");
+    }
+
+    void merge() {
+        if (pending.empty()) {
+            return;
+        }
+        // Merge from the back, so only entries later than the batch move.
+        size_t i = sorted.size(), j = pending.size();
+        sorted.resize(i + j);
+        for (size_t k = sorted.size(); j > 0;) {
+            if (i > 0 && earlier(pending[j - 1], sorted[i - 1])) {
+                sorted[--k] = sorted[--i];
+            } else {
+                sorted[--k] = pending[--j];
+            }
+        }
+        pending.clear();
+    }
+
+public:
+    void insert(uint32_t when, size_t slot) {
+        Entry entry{when, static_cast<uint32_t>(slot)};
+        pending.insert(upper_bound(pending.begin(), pending.end(), entry, earlier), entry);
+        if (pending.size() >= BATCH) merge();
+    }
+
+    void erase(uint32_t when, size_t slot) {
+        auto it = locate(pending, when, slot);
+        if (it != pending.end()) {
+            pending.erase(it);
+            return;
+        }
+        listed(when, slot)->slot = DEAD;
+        if (++dead * 4 > sorted.size()) {
+            sorted.erase(remove_if(sorted.begin(), sorted.end(), [](const Entry& entry) { return entry.slot == DEAD; }),
+                         sorted.end());
+            dead = 0;
+        }
+    }
+
+    // The reservation at `when` moved from slot `from` to slot `to`.
+    void relocate(uint32_t when, size_t from, size_t to) { listed(when, from)->slot = static_cast<uint32_t>(to); }
+
+    // Visits the slots with from <= when <= to in time order. Stops once visit
+    // returns false.
+    template <typename Visitor>
+    void range(uint32_t from, uint32_t to, Visitor visit) const {
+        auto it = lower_bound(sorted.begin(), sorted.end(), Entry{from, 0}, earlier);
+        auto batched = lower_bound(pending.begin(), pending.end(), Entry{from, 0}, earlier);
+        while (true) {
+            bool inSorted = it != sorted.end() && it->when <= to;
+            bool inBatch = batched != pending.end() && batched->when <= to;
+            if (!inSorted && !inBatch) return;
+            const Entry& entry = inSorted && (!inBatch || !earlier(*batched, *it)) ? *it++ : *batched++;
+            if (entry.slot != DEAD && !visit(entry.slot)) return;
+        }
+    }
+
+    void rebuild(const vector<Reservation>& rows) {
+        clear();
+        sorted.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            sorted.push_back({packReservationTime(rows[i].date, rows[i].time), static_cast<uint32_t>(i)});
+        }
+        stable_sort(sorted.begin(), sorted.end(), earlier);
+    }
+
+    void clear() {
+        sorted.clear();
+        pending.clear();
+        dead = 0;
+    }
+
+    size_t memoryBytes() const { return (sorted.capacity() + pending.capacity()) * sizeof(Entry); }
+};
+
+// -------- Singleton Pattern --------
+class ReservationManager {
+private:
+    // Per-date bookkeeping for the segment files; see "Date Segments" above.
+    struct SegmentState {
+        size_t records = 0;      // reservations on this date, resident or on disk
+        uint32_t tableMask = 0;  // tables booked by this date's reservations
+        bool onDisk = false;     // segments/<date>.bin exists
+        bool loaded = false;     // its reservations are in `reservations`
+        bool dirty = false;      // resident reservations differ from the file
+        chrono::steady_clock::time_point lastAccess;
+    };
+
+    vector<Reservation> reservations;  // reservations of every loaded segment, in no particular order
+    ReservationIdIndex idIndex;        // ID -> position in reservations; see the resident helpers
+    UnloadedIdIndex unloadedIds;       // ID -> unloaded segment
+    UnloadedIdIndex archivedIds;       // ID -> archive month, once archiveIndexed
+    CustomerIndex customerIndex;       // customer -> positions in reservations and unloaded segments
+    PhoneIndex phoneIndex;             // packed phone -> the same
+    TimeIndex timeIndex;               // positions in reservations by date and time
+    bool unloadedSegmentsIndexed = false;  // segments never loaded are in the secondary indexes and unloadedIds
+    bool archiveIndexed = false;           // every archive file's IDs are in archivedIds
+    map<string, SegmentState> segments;
+    static unique_ptr<ReservationManager> instance;
+    long long nextReservationId;  // above every numeric ID ever stored; see noteReservationId
+    long long nextLsn;
+    PersistenceQueue persistence;
+    long long checkpointedLsn;
+    recursive_mutex stateMutex;
+
+    // Compaction accounting, guarded by stateMutex. compactionMutex keeps a
+    // requested compaction from overlapping the background one.
+    uint64_t journalRecords;
+    uint64_t journalTombstones;
+    long long journalClockSecond;  // second of the last clock record; -1 forces a new one
+    CompactionStats compactionStats;
+    mutex compactionMutex;
+
+    // Checkpoint thread state, guarded by checkpointMutex.
+    thread checkpointThread;
+    mutex checkpointMutex;
+    condition_variable checkpointSignal;
+    bool checkpointRequested;
+    bool stopping;
+
+    // Background backup; backupStatus is guarded by backupMutex.
+    thread backupThread;
+    mutex backupMutex;
+    BackupStatus backupState;
+
+    // Journal tailing in follower mode (see "Journal Follower"), guarded by stateMutex.
+    struct FollowerState {
+        ifstream journal;
+        string pending;                  // bytes read but not yet applied, at most a partial record
+        long long readBytes = 0;         // offset of `journal`
+        long long firstLsn = -1;         // first record seen through `journal`
+        long long reloadAtLsn = -1;      // reload once the manifest reaches this LSN
+        bool stalled = false;            // records are missing; nothing applies until the reload
+        long long primaryClockMillis = 0;
+        long long caughtUpMillis = 0;
+        string error;
+    } follower;
+
+    // Null for the journal backend; otherwise every change goes here instead.
+    unique_ptr<StorageEngine> engine;
+
+    ReservationManager() : nextReservationId(1), nextLsn(1),
+                           persistence(storageConfig.durability, storageConfig.groupCommitMillis,
+                                       storageConfig.groupCommitOps, storageConfig.persistenceQueueCapacity),
+                           checkpointedLsn(0), journalRecords(0), journalTombstones(0), journalClockSecond(-1),
+                           checkpointRequested(false), stopping(false) {
+        engine = createStorageEngine(storageConfig.backend);
+        loadReservations();
+        // A follower's background thread tails the journal instead of checkpointing.
+        // Engines have nothing to checkpoint.
+        if (storageConfig.follower) {
+            checkpointThread = thread(&ReservationManager::runFollower, this);
+        } else if (!engine) {
+            checkpointThread = thread(&ReservationManager::runCheckpoints, this);
+        }
+    }
+
+    string getCurrentTimestamp() {
+        ostringstream oss;
+        oss << CURRENT_DATE << " " << (CURRENT_HOUR < 10 ? "0" : "") << CURRENT_HOUR << ":"
+            << (CURRENT_MINUTE < 10 ? "0" : "") << CURRENT_MINUTE << ":00";
+        return oss.str();
+    }
+
+    // Log lines are written by the persistence thread, never on the request path.
+    void writeLogToFile(const string& logEntry) {
+        if (storageConfig.follower) {
+            return;
+        }
+        persistence.append(PersistedFile::Log, logEntry + "\n\n");
+    }
+
+    static bool inActiveWindow(const string& key) {
+        return key >= CURRENT_DATE && key < addDays(CURRENT_DATE, storageConfig.activeWindowDays);
+    }
+
+    // Segments older than the archive horizon. "undated" sorts after every date,
+    // so the cold segments are always a prefix of the map.
+    bool hasColdSegments() const {
+        return !segments.empty() &&
+               segments.begin()->first < addDays(CURRENT_DATE, -storageConfig.archiveHorizonDays);
+    }
+
+    // Makes a segment's reservations resident, reading its file on first use.
+    void touchSegment(const string& key) {
+        SegmentState& segment = segments[key];
+        segment.lastAccess = chrono::steady_clock::now();
+        if (segment.loaded) {
+            return;
+        }
+        segment.loaded = true;
+        if (!segment.onDisk) {
+            return;
+        }
+        MappedFile file(segmentPath(key));
+        if (!file.isOpen()) {
+            throw ReservationException("Unable to open reservation segment " + key + ".");
+        }
+        size_t record = 0;
+        readBinarySnapshot(file, [this, &key, &record](const Reservation& res) {
+            customerIndex.removeUnloaded(res.customerName, key, record);
+            phoneIndex.removeUnloaded(phoneKey(res.phoneNumber), key, record++);
+            unloadedIds.remove(res.id, key);
+            // A crash between segment writes can leave a moved reservation in
+            // both files; the resident copy is the newer one.
+            if (findReservationIndex(res.id) >= 0) {
+                return;
+            }
+            addResident(res);
+            noteReservationId(res.id);
+        });
+    }
+
+    void markDirty(const string& date) {
+        string key = segmentKeyFor(date);
+        touchSegment(key);
+        segments[key].dirty = true;
+    }
+
+    // Visits every stored reservation: resident ones first, then the segments that
+    // are not loaded, decoded straight from their files without making them resident.
+    // Stops early once visit returns false.
+    template <typename Visitor>
+    void forEachStoredReservation(Visitor visit) {
+        for (const auto& res : reservations) {
+            if (!visit(res)) return;
+        }
+        for (const auto& entry : segments) {
+            if (entry.second.loaded || !entry.second.onDisk) continue;
+            MappedFile file(segmentPath(entry.first));
+            if (!file.isOpen()) continue;
+            BinarySnapshotView view(file);
+            for (size_t i = 0; i < view.size(); ++i) {
+                if (!visit(view.reservation(i))) return;
+            }
+        }
+    }
+
+    // Visits the stored reservations dated fromDate..toDate (inclusive, YYYY-MM-DD;
+    // empty for no bound) in date and time order. Only the segments inside the range
+    // are touched: a loaded day is read from timeIndex, an unloaded one from its file
+    // without making it resident. Stops early once visit returns false.
+    template <typename Visitor>
+    void forEachReservationBetween(const string& fromDate, const string& toDate, Visitor visit) {
+        // Resident reservations whose date does not pack (legacy data only), gathered
+        // by date once per query.
+        map<string, vector<uint32_t>> unpacked;
+        timeIndex.range(UNTIMED, UNTIMED, [&](uint32_t slot) {
+            const string& date = reservations[slot].date;
+            if ((fromDate.empty() || date >= fromDate) && (toDate.empty() || date <= toDate)) {
+                unpacked[date].push_back(slot);
+            }
+            return true;
+        });
+        auto entry = fromDate.empty() ? segments.begin() : segments.lower_bound(fromDate);
+        for (; entry != segments.end() && (toDate.empty() || entry->first <= toDate); ++entry) {
+            const string& day = entry->first;
+            if (!isDateShaped(day)) continue;
+            if (entry->second.loaded) {
+                bool more = true;
+                uint32_t start = packReservationTime(day, "00:00");
+                if (start != UNTIMED) {
+                    timeIndex.range(start, start + 1439, [&](uint32_t slot) { return more = visit(reservations[slot]); });
+                }
+                auto legacy = unpacked.find(day);
+                if (legacy != unpacked.end()) {
+                    for (size_t i = 0; more && i < legacy->second.size(); ++i) {
+                        more = visit(reservations[legacy->second[i]]);
+                    }
+                }
+                if (!more) return;
+                continue;
+            }
+            if (!entry->second.onDisk) continue;
+            MappedFile file(segmentPath(day));
+            if (!file.isOpen()) continue;
+            BinarySnapshotView view(file);
+            // Every record in the file shares its date, so the packed minute orders them.
+            vector<pair<uint16_t, uint32_t>> order;  // (minute, record)
+            order.reserve(view.size());
+            for (size_t i = 0; i < view.size(); ++i) {
+                order.emplace_back(view.minute(i), static_cast<uint32_t>(i));
+            }
+            sort(order.begin(), order.end());
+            for (const auto& record : order) {
+                if (!visit(view.reservation(record.second))) return;
+            }
+        }
+    }
+
+    // Key of the unloaded segment holding id, or "" when no segment has it.
+    string findUnloadedSegment(long long id) {
+        if (id < 0) return "";
+        indexUnloadedSegments();
+        return unloadedIds.find(id);
+    }
+
+    // Index of id in `reservations`, loading its segment first if needed.
+    int locateReservation(long long id) {
+        int index = findReservationIndex(id);
+        if (index >= 0) {
+            segments[segmentKeyFor(reservations[index].date)].lastAccess = chrono::steady_clock::now();
+            return index;
+        }
+        string key = findUnloadedSegment(id);
+        if (key.empty()) {
+            return -1;
+        }
+        touchSegment(key);
+        return findReservationIndex(id);
+    }
+
+    // The availability rule every write path uses: a table is booked at a date and
+    // time when a stored reservation, other than the one at skipIndex, holds it then.
+    // An unloaded segment whose tableMask leaves the table out is not read.
+    bool tableBookedAt(const string& date, const string& time, int tableNumber, int skipIndex = -1) {
+        string key = segmentKeyFor(date);
+        auto segment = segments.find(key);
+        if (segment != segments.end() && !segment->second.loaded) {
+            if (tableNumber >= 0 && tableNumber < 32 && !(segment->second.tableMask & (1u << tableNumber))) {
+                return false;
+            }
+            touchSegment(key);
+        }
+        bool booked = false;
+        uint32_t when = packReservationTime(date, time);
+        timeIndex.range(when, when, [&](uint32_t slot) {
+            const Reservation& res = reservations[slot];
+            booked = static_cast<int>(slot) != skipIndex && res.tableNumber == tableNumber && res.date == date &&
+                     res.time == time;
+            return !booked;
+        });
+        return booked;
+    }
+
+    // Drops clean segments outside the active window that have not been touched for
+    // segmentIdleSeconds. Called with stateMutex held.
+    void evictIdleSegments() {
+        auto cutoff = chrono::steady_clock::now() - chrono::seconds(storageConfig.segmentIdleSeconds);
+        vector<string> evicted;
+        for (auto& entry : segments) {
+            SegmentState& segment = entry.second;
+            if (segment.loaded && !segment.dirty && segment.onDisk && segment.lastAccess <= cutoff &&
+                !inActiveWindow(entry.first)) {
+                segment.loaded = false;
+                evicted.push_back(entry.first);
+            }
+        }
+        if (evicted.empty()) {
+            return;
+        }
+        for (const auto& key : evicted) {
+            indexUnloadedSegment(key);
+        }
+        removeResidentIf([&evicted](const Reservation& res) {
+            return binary_search(evicted.begin(), evicted.end(), segmentKeyFor(res.date));
+        });
+    }
+
+    // Runs on the checkpoint thread without the state lock; the caller copied the
+    // dirty segments under it. Segment files go first and the manifest last, so a
+    // crash in between leaves segments that are at most newer than the manifest's
+    // LSN, and replaying those journal records again is harmless.
+    static long long saveReservations(const vector<pair<string, vector<Reservation>>>& dirtySegments,
+                                      const string& manifest, long long snapshotLsn) {
+        filesystem::create_directories(SEGMENT_DIR);
+        IoThrottle throttle(storageConfig.compactionBytesPerSecond);
+        long long bytesWritten = 0;
+        for (const auto& segment : dirtySegments) {
+            error_code ec;
+            if (segment.second.empty()) {
+                filesystem::remove(segmentPath(segment.first), ec);
+                continue;
+            }
+            const string temp = segmentPath(segment.first) + ".tmp";
+            writeBinarySnapshot(temp, segment.second, snapshotLsn);
+            commitFile(temp, segmentPath(segment.first));
+            long long bytes = fileBytes(segmentPath(segment.first));
+            bytesWritten += bytes;
+            throttle.consume(bytes);
+        }
+        writeFileAtomically(MANIFEST_FILE, manifest);
+
+        // The segments and manifest supersede the files older versions kept.
+        error_code ec;
+        filesystem::remove(SNAPSHOT_FILE, ec);
+        filesystem::remove("reservations.txt", ec);
+        filesystem::remove("next_id.txt", ec);
+        return bytesWritten;
+    }
+
+    // Everything the store keeps on disk: both journals, segments and manifest.
+    long long storeDiskBytes() {
+        long long bytes = persistence.size(PersistedFile::Journal) + fileBytes(ROTATED_JOURNAL_FILE) +
+                          fileBytes(SNAPSHOT_FILE) + fileBytes("reservations.txt");
+        error_code ec;
+        for (filesystem::directory_iterator it(SEGMENT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+            bytes += fileBytes(it->path().string());
+        }
+        return bytes;
+    }
+
+    // Segment-format size of the live reservations. Called with stateMutex held;
+    // unloaded segments are counted by file size, which is already compact.
+    long long liveBytes() {
+        long long bytes = 0;
+        for (const auto& res : reservations) {
+            bytes += static_cast<long long>(packedReservationBytes(res));
+        }
+        for (const auto& entry : segments) {
+            if (entry.second.loaded) {
+                bytes += entry.second.records > 0 || entry.second.dirty ? sizeof(SnapshotHeader) : 0;
+            } else {
+                bytes += fileBytes(segmentPath(entry.first));
+            }
+        }
+        return bytes;
+    }
+
+    // Queues the record and returns a ticket for persistence.waitDurable(). Callers
+    // release stateMutex before waiting so other requests can join the same fsync.
+    uint64_t appendJournal(const string& record) {
+        if (engine) {
+            engine->record(record);
+            return 0;
+        }
+        long long now = wallClockMillis();
+        if (now / 1000 != journalClockSecond) {
+            journalClockSecond = now / 1000;
+            persistence.append(PersistedFile::Journal, journalLine(to_string(nextLsn++) + "|T|" + to_string(now)));
+        }
+        uint64_t ticket = persistence.append(PersistedFile::Journal, journalLine(to_string(nextLsn) + "|" + record));
+        nextLsn++;
+        journalRecords++;
+        journalTombstones += record[0] == 'C' ? 1 : 0;
+        if (persistence.size(PersistedFile::Journal) >= storageConfig.checkpointJournalBytes) {
+            requestCheckpoint();
+        }
+        return ticket;
+    }
+
+    // Called with stateMutex held: new records go to a fresh journal while the
+    // checkpoint thread writes out everything up to the rotated one.
+    void rotateJournal() {
+        journalClockSecond = -1;
+        persistence.rotate(PersistedFile::Journal, JOURNAL_FILE, [] {
+            if (filesystem::exists(ROTATED_JOURNAL_FILE)) {
+                // The previous checkpoint never finished, so its records are still needed.
+                ifstream current(JOURNAL_FILE, ios::binary);
+                ofstream rotated(ROTATED_JOURNAL_FILE, ios::app | ios::binary);
+                if (current.peek() != ifstream::traits_type::eof()) {
+                    rotated << current.rdbuf();
+                }
+                rotated.close();
+                current.close();
+                ofstream(JOURNAL_FILE, ios::trunc).close();
+            } else {
+                error_code ec;
+                filesystem::rename(JOURNAL_FILE, ROTATED_JOURNAL_FILE, ec);
+            }
+        });
+    }
+
+    // Takes every cold segment out of the hot set and returns its reservations grouped
+    // by archive month. Called with stateMutex held.
+    map<string, vector<Reservation>> detachColdSegments(vector<string>& coldKeys) {
+        map<string, vector<Reservation>> byMonth;
+        string cutoff = addDays(CURRENT_DATE, -storageConfig.archiveHorizonDays);
+        for (auto it = segments.begin(); it != segments.end() && it->first < cutoff; ++it) {
+            touchSegment(it->first);
+            coldKeys.push_back(it->first);
+        }
+        if (coldKeys.empty()) {
+            return byMonth;
+        }
+        auto isCold = [&coldKeys](const Reservation& res) {
+            return binary_search(coldKeys.begin(), coldKeys.end(), segmentKeyFor(res.date));
+        };
+        for (const auto& res : reservations) {
+            if (isCold(res)) {
+                byMonth[res.date.substr(0, 7)].push_back(res);
+                archivedIds.add(res.id, res.date.substr(0, 7));
+            }
+        }
+        removeResidentIf(isCold);
+        for (const auto& key : coldKeys) {
+            segments.erase(key);
+        }
+        return byMonth;
+    }
+
+    // Undoes detachColdSegments after a failed checkpoint. The reattached segments
+    // are dirty, so the next checkpoint rewrites them from memory.
+    void reattachColdSegments(const map<string, vector<Reservation>>& byMonth) {
+        for (const auto& month : byMonth) {
+            for (const auto& res : month.second) {
+                archivedIds.remove(res.id, month.first);
+                markDirty(res.date);
+                addResident(res);
+            }
+        }
+    }
+
+    // Writes only the segments changed since the last checkpoint, paced by
+    // compactionBytesPerSecond, and records the space amplification it left behind.
+    void checkpoint() {
+        lock_guard<mutex> compactionLock(compactionMutex);
+        auto start = chrono::steady_clock::now();
+        vector<pair<string, vector<Reservation>>> dirtySegments;
+        ostringstream manifest;
+        long long snapshotLsn;
+        double amplificationBefore;
+        uint64_t foldedRecords, droppedTombstones;
+        vector<string> coldKeys;
+        map<string, vector<Reservation>> coldByMonth;
+        long long checkpointMillis;
+        {
+            lock_guard<recursive_mutex> lock(stateMutex);
+            snapshotLsn = nextLsn - 1;
+            checkpointMillis = wallClockMillis();
+            if (snapshotLsn == checkpointedLsn && !filesystem::exists(ROTATED_JOURNAL_FILE) && !hasColdSegments()) {
+                evictIdleSegments();
+                return;
+            }
+            amplificationBefore = spaceAmplification(storeDiskBytes(), liveBytes());
+            foldedRecords = journalRecords;
+            droppedTombstones = journalTombstones;
+            journalRecords = 0;
+            journalTombstones = 0;
+            coldByMonth = detachColdSegments(coldKeys);
+            map<string, size_t> dirtyIndex;
+            for (auto& entry : segments) {
+                if (entry.second.dirty) {
+                    dirtyIndex[entry.first] = dirtySegments.size();
+                    dirtySegments.emplace_back(entry.first, vector<Reservation>());
+                }
+            }
+            for (const auto& res : reservations) {
+                auto it = dirtyIndex.find(segmentKeyFor(res.date));
+                if (it != dirtyIndex.end()) {
+                    dirtySegments[it->second].second.push_back(res);
+                }
+            }
+            for (const auto& segment : dirtySegments) {
+                SegmentState& state = segments[segment.first];
+                state.dirty = false;
+                state.records = segment.second.size();
+                state.onDisk = !segment.second.empty();
+                state.tableMask = 0;
+                for (const auto& res : segment.second) {
+                    if (res.tableNumber >= 0 && res.tableNumber < 32) state.tableMask |= 1u << res.tableNumber;
+                }
+                if (segment.second.empty()) {
+                    segments.erase(segment.first);
+                }
+            }
+            manifest << manifestHeader(snapshotLsn, nextReservationId);
+            for (const auto& entry : segments) {
+                if (entry.second.onDisk) {
+                    manifest << entry.first << "|" << entry.second.records << "|" << entry.second.tableMask << "\n";
+                }
+            }
+            rotateJournal();
+        }
+        long long bytesWritten;
+        try {
+            archiveReservations(coldByMonth, snapshotLsn);
+            bytesWritten = saveReservations(dirtySegments, manifest.str(), snapshotLsn);
+            for (const auto& key : coldKeys) {
+                error_code ec;
+                filesystem::remove(segmentPath(key), ec);
+            }
+        } catch (...) {
+            // Keep the segments resident and dirty so a later checkpoint retries them.
+            lock_guard<recursive_mutex> lock(stateMutex);
+            for (const auto& segment : dirtySegments) {
+                segments[segment.first].dirty = true;
+            }
+            reattachColdSegments(coldByMonth);
+            journalRecords += foldedRecords;
+            journalTombstones += droppedTombstones;
+            throw;
+        }
+        if (storageConfig.restoreHistory > 0) {
+            try {
+                recordCheckpointHistory(snapshotLsn, checkpointMillis);
+            } catch (const exception& ex) {
+                cerr << "Error: Unable to record checkpoint history: " << ex.what() << endl;
+            }
+            archiveRotatedJournal(snapshotLsn);
+            pruneCheckpointHistory(static_cast<size_t>(storageConfig.restoreHistory));
+        } else {
+            error_code ec;
+            filesystem::remove(ROTATED_JOURNAL_FILE, ec);
+        }
+        lock_guard<recursive_mutex> lock(stateMutex);
+        checkpointedLsn = snapshotLsn;
+        evictIdleSegments();
+        compactionStats.runs++;
+        compactionStats.archivedRecords = 0;
+        for (const auto& month : coldByMonth) {
+            compactionStats.archivedRecords += month.second.size();
+        }
+        compactionStats.foldedRecords = foldedRecords;
+        compactionStats.droppedTombstones = droppedTombstones;
+        compactionStats.bytesWritten = bytesWritten;
+        compactionStats.amplificationBefore = amplificationBefore;
+        compactionStats.amplificationAfter = spaceAmplification(storeDiskBytes(), liveBytes());
+        compactionStats.lastMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    void requestCheckpoint() {
+        {
+            lock_guard<mutex> lock(checkpointMutex);
+            checkpointRequested = true;
+        }
+        checkpointSignal.notify_one();
+    }
+
+    // Checkpoints every checkpointIntervalSeconds, or sooner once the journal
+    // passes checkpointJournalBytes.
+    void runCheckpoints() {
+        unique_lock<mutex> lock(checkpointMutex);
+        while (!stopping) {
+            checkpointSignal.wait_for(lock, chrono::seconds(storageConfig.checkpointIntervalSeconds),
+                                      [this] { return stopping || checkpointRequested; });
+            if (stopping) {
+                break;
+            }
+            checkpointRequested = false;
+            lock.unlock();
+            try {
+                checkpoint();
+            } catch (const exception& ex) {
+                cerr << "Error: Checkpoint failed: " << ex.what() << endl;
+            }
+            lock.lock();
+        }
+    }
+
+    // Every ID that enters the store passes through here (new, replayed, loaded or
+    // renamed), which keeps nextReservationId above all of them. Allocating
+    // nextReservationId therefore never collides and needs no lookup.
+    void noteReservationId(long long id) {
+        if (id < LLONG_MAX) {
+            nextReservationId = max(nextReservationId, id + 1);
+        }
+    }
+
+    // Legacy records share the invalid ID -1 and are never looked up by it.
+    int findReservationIndex(long long id) const {
+        return id < 0 ? -1 : idIndex.find(id);
+    }
+
+    // Resident helpers: every change to `reservations` goes through these so idIndex
+    // and the secondary indexes stay in step. Removal moves the last reservation into
+    // the hole.
+    void addResident(Reservation res) {
+        idIndex.insert(res.id, reservations.size());
+        customerIndex.insert(res.customerName, reservations.size());
+        phoneIndex.insert(phoneKey(res.phoneNumber), reservations.size());
+        timeIndex.insert(packReservationTime(res.date, res.time), reservations.size());
+        reservations.push_back(move(res));
+    }
+
+    void removeResidentAt(size_t index) {
+        size_t last = reservations.size() - 1;
+        idIndex.erase(reservations[index].id, index);
+        customerIndex.erase(reservations[index].customerName, index);
+        phoneIndex.erase(phoneKey(reservations[index].phoneNumber), index);
+        timeIndex.erase(packReservationTime(reservations[index].date, reservations[index].time), index);
+        if (index != last) {
+            idIndex.relocate(reservations[last].id, last, index);
+            customerIndex.relocate(reservations[last].customerName, last, index);
+            phoneIndex.relocate(phoneKey(reservations[last].phoneNumber), last, index);
+            timeIndex.relocate(packReservationTime(reservations[last].date, reservations[last].time), last, index);
+            reservations[index] = move(reservations[last]);
+        }
+        reservations.pop_back();
+    }
+
+    void replaceResidentAt(size_t index, const Reservation& res) {
+        if (reservations[index].id != res.id) {
+            idIndex.erase(reservations[index].id, index);
+            idIndex.insert(res.id, index);
+        }
+        if (reservations[index].customerName != res.customerName) {
+            customerIndex.erase(reservations[index].customerName, index);
+            customerIndex.insert(res.customerName, index);
+        }
+        if (reservations[index].phoneNumber != res.phoneNumber) {
+            phoneIndex.erase(phoneKey(reservations[index].phoneNumber), index);
+            phoneIndex.insert(phoneKey(res.phoneNumber), index);
+        }
+        uint32_t oldWhen = packReservationTime(reservations[index].date, reservations[index].time);
+        uint32_t newWhen = packReservationTime(res.date, res.time);
+        if (oldWhen != newWhen) {
+            timeIndex.erase(oldWhen, index);
+            timeIndex.insert(newWhen, index);
+        }
+        reservations[index] = res;
+    }
+
+    // Bulk removal (eviction, archiving) rebuilds the indexes once instead.
+    template <typename Predicate>
+    void removeResidentIf(Predicate remove) {
+        reservations.erase(remove_if(reservations.begin(), reservations.end(), remove), reservations.end());
+        idIndex.rebuild(reservations);
+        customerIndex.rebuild(reservations, [](const Reservation& res) -> const string& { return res.customerName; });
+        phoneIndex.rebuild(reservations, [](const Reservation& res) { return phoneKey(res.phoneNumber); });
+        timeIndex.rebuild(reservations);
+    }
+
+    // Lists a segment file's records in the secondary indexes and unloadedIds,
+    // reading only the ID, name and phone columns.
+    void indexUnloadedSegment(const string& key) {
+        MappedFile file(segmentPath(key));
+        if (!file.isOpen()) {
+            return;
+        }
+        BinarySnapshotView view(file);
+        string name;
+        for (size_t i = 0; i < view.size(); ++i) {
+            name.assign(view.customerName(i));
+            customerIndex.addUnloaded(name, key, i);
+            phoneIndex.addUnloaded(phoneKey(view.phoneNumber(i)), key, i);
+            unloadedIds.add(view.id(i), key);
+        }
+    }
+
+    // Indexes the segments that have never been loaded. Runs once, on the first
+    // secondary index or unloaded ID lookup; eviction and loading keep the indexes
+    // current after that.
+    void indexUnloadedSegments() {
+        if (unloadedSegmentsIndexed) {
+            return;
+        }
+        for (const auto& entry : segments) {
+            if (!entry.second.loaded && entry.second.onDisk) indexUnloadedSegment(entry.first);
+        }
+        unloadedSegmentsIndexed = true;
+    }
+
+    // Visits the stored reservations index lists under value: resident ones first,
+    // then its records in unloaded segments, each segment mapped once. Stops once
+    // visit returns false.
+    template <typename Value, typename Visitor>
+    void forEachIndexedReservation(const SecondaryIndex<Value>& index, const Value& value, Visitor visit) {
+        indexUnloadedSegments();
+        int key = index.find(value);
+        if (key < 0) {
+            return;
+        }
+        for (uint32_t slot : index.slots(key)) {
+            if (!visit(reservations[slot])) return;
+        }
+        const auto& unloaded = index.unloaded(key);
+        for (size_t i = 0; i < unloaded.size();) {
+            uint32_t segment = unloaded[i].segment;
+            MappedFile file(segmentPath(index.segmentKey(segment)));
+            size_t end = i;
+            while (end < unloaded.size() && unloaded[end].segment == segment) end++;
+            if (!file.isOpen()) {
+                i = end;
+                continue;
+            }
+            BinarySnapshotView view(file);
+            for (; i < end; ++i) {
+                if (unloaded[i].record < view.size() && !visit(view.reservation(unloaded[i].record))) return;
+            }
+        }
+    }
+
+    // Replay helpers are idempotent so a record applied twice leaves the same state.
+    // A reserve record's ID was new when it was written, so an earlier copy can only
+    // be one from replaying the record twice, in the segment of the same date.
+    void applyReserve(const Reservation& res) {
+        markDirty(res.date);
+        int index = findReservationIndex(res.id);
+        if (index >= 0) {
+            replaceResidentAt(index, res);
+        } else {
+            addResident(res);
+        }
+        noteReservationId(res.id);
+    }
+
+    void applyCancel(long long id) {
+        int index = locateReservation(id);
+        if (index >= 0) {
+            markDirty(reservations[index].date);
+            removeResidentAt(index);
+        }
+    }
+
+    void applyUpdate(long long oldId, const Reservation& res) {
+        int index = locateReservation(oldId);
+        if (index < 0) {
+            applyReserve(res);
+            return;
+        }
+        markDirty(reservations[index].date);
+        markDirty(res.date);
+        replaceResidentAt(index, res);
+        noteReservationId(res.id);
+    }
+
+    static Reservation parseReservationFields(const vector<string>& fields, size_t first) {
+        return Reservation(parseReservationIdOrInvalid(fields[first]), fields[first + 1], fields[first + 2],
+                           stoi(fields[first + 3]),
+                           fields[first + 4], fields[first + 5], stoi(fields[first + 6]));
+    }
+
+    // Returns false on a malformed record. scanJournal only hands over complete lines
+    // that pass their checksum, so such a record was written whole (by a version that
+    // let a '|' into a field, say) and the callers report and skip it; a torn write
+    // never gets this far.
+    bool replayJournalRecord(const string& line, long long snapshotLsn) {
+        vector<string> fields = splitFields(line, '|');
+        if (fields.size() < 3) {
+            return false;
+        }
+        try {
+            long long lsn = stoll(fields[0]);
+            const string& type = fields[1];
+            if (type == "R" && fields.size() == 9) {
+                if (lsn > snapshotLsn) applyReserve(parseReservationFields(fields, 2));
+            } else if (type == "U" && fields.size() == 10) {
+                if (lsn > snapshotLsn) applyUpdate(parseReservationIdOrInvalid(fields[2]), parseReservationFields(fields, 3));
+            } else if (type == "C" && fields.size() == 3) {
+                if (lsn > snapshotLsn) applyCancel(parseReservationIdOrInvalid(fields[2]));
+            } else if (type == "T" && fields.size() == 3) {
+                nextLsn = max(nextLsn, lsn + 1);
+                return true;
+            } else {
+                return false;
+            }
+            if (lsn > snapshotLsn) {
+                journalRecords++;
+                journalTombstones += type == "C" ? 1 : 0;
+            }
+            nextLsn = max(nextLsn, lsn + 1);
+        } catch (const ReservationException&) {
+            throw;
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+
+    // Reads segments/manifest.txt; false if this store has no segments yet.
+    bool loadManifest(long long& snapshotLsn) {
+        ifstream manifest(MANIFEST_FILE);
+        string line;
+        if (!manifest.is_open() || !getline(manifest, line)) {
+            return false;
+        }
+        if (checkFormatHeader(line, MANIFEST_TAG, MANIFEST_FORMAT_VERSION) && !getline(manifest, line)) {
+            return false;
+        }
+        size_t bar = line.find('|');
+        if (!parseInteger(string_view(line).substr(0, bar), snapshotLsn)) {
+            return false;
+        }
+        line = bar == string::npos ? "" : line.substr(bar);
+        long long savedId;
+        if (line.size() > 1 && line[0] == '|' && parseInteger(string_view(line).substr(1), savedId)) {
+            nextReservationId = max(nextReservationId, savedId);
+        }
+        while (getline(manifest, line)) {
+            string_view fields[3];
+            size_t records;
+            uint32_t tableMask;
+            if (!splitFieldViews(line, '|', fields, 3) || fields[0].empty() || !parseInteger(fields[1], records) ||
+                !parseInteger(fields[2], tableMask)) {
+                cerr << "Error: Skipping corrupt line in " << MANIFEST_FILE << ": " << line << endl;
+                continue;
+            }
+            SegmentState& segment = segments[string(fields[0])];
+            segment.onDisk = true;
+            segment.records = records;
+            segment.tableMask = tableMask;
+        }
+        return true;
+    }
+
+    void loadReservations() {
+        if (engine) {
+            loadFromEngine();
+            return;
+        }
+        if (storageConfig.follower) {
+            loadFollower();
+            return;
+        }
+        // Stores written by older versions become segments before anything is read.
+        MigrationStats migration;
+        migrateLegacyReservations(migration);
+
+        long long snapshotLsn = 0;
+        loadManifest(snapshotLsn);
+        for (const auto& entry : segments) {
+            if (inActiveWindow(entry.first)) {
+                touchSegment(entry.first);
+            }
+        }
+
+        // Version 1 manifests kept the next ID in next_id.txt.
+        ifstream idFile("next_id.txt");
+        if (idFile.is_open()) {
+            long long savedId;
+            if (idFile >> savedId) {
+                nextReservationId = max(nextReservationId, savedId);
+            }
+            idFile.close();
+        }
+        nextLsn = snapshotLsn + 1;
+        checkpointedLsn = snapshotLsn;
+
+        bool replayed = replayJournalFile(ROTATED_JOURNAL_FILE, snapshotLsn);
+        replayed = replayJournalFile(JOURNAL_FILE, snapshotLsn) || replayed;
+
+        persistence.open(PersistedFile::Journal, JOURNAL_FILE,
+                         journalLine(formatHeader(JOURNAL_TAG, JOURNAL_FORMAT_VERSION)));
+        persistence.open(PersistedFile::Log, "logs.txt");
+
+        // Fold the replayed journal into segment files so it does not have to be
+        // read again on the next start.
+        if (replayed || hasColdSegments()) {
+            checkpointedLsn = -1;
+            requestCheckpoint();
+        }
+    }
+
+    // Reports a complete record replayJournalRecord could not parse and moves past
+    // its LSN, so the records after it still apply.
+    void skipMalformedRecord(const string& path, string_view payload) {
+        cerr << "Error: Skipping malformed record in " << path << ": " << payload << endl;
+        long long lsn;
+        if (parseInteger(payload.substr(0, payload.find('|')), lsn)) {
+            nextLsn = max(nextLsn, lsn + 1);
+        }
+    }
+
+    // Replays the intact prefix of a journal and truncates whatever follows it, so a
+    // torn or corrupt tail is dropped once instead of hiding the records appended
+    // after it. Only a missing newline or a failed checksum ends the prefix.
+    bool replayJournalFile(const string& path, long long snapshotLsn) {
+        bool replayed = false;
+        size_t fileSize, intact;
+        {
+            MappedFile journal(path);
+            if (!journal.isOpen()) {
+                return false;
+            }
+            fileSize = journal.size();
+            intact = scanJournal(journal.data(), journal.size(), [&](string_view payload) {
+                if (checkFormatHeader(payload, JOURNAL_TAG, JOURNAL_FORMAT_VERSION)) {
+                    return true;
+                }
+                if (!replayJournalRecord(string(payload), snapshotLsn)) {
+                    skipMalformedRecord(path, payload);
+                    return true;
+                }
+                replayed = true;
+                return true;
+            });
+        }
+        if (intact < fileSize) {
+            cerr << "Error: " << path << " has a torn or corrupt record at byte " << intact << "; discarding the last "
+                 << fileSize - intact << " bytes." << endl;
+            error_code ec;
+            filesystem::resize_file(path, intact, ec);
+            if (ec || !syncFile(path)) {
+                throw ReservationException("Unable to truncate " + path + ".");
+            }
+        }
+        return replayed;
+    }
+
+    // Runs on backupThread. The files are pinned (mapped) under compactionMutex, which
+    // keeps checkpoints from replacing segments meanwhile, and then copied at the
+    // throttled rate without it, so checkpoints and compaction carry on during the
+    // copy. The LSN the backup stops at and the journal through it are captured under
+    // stateMutex; the journal is copied to memory, since rotation may truncate it.
+    void runBackup(const filesystem::path& dir) {
+        auto start = chrono::steady_clock::now();
+        BackupStatus result;
+        result.path = dir.string();
+        try {
+            vector<pair<string, unique_ptr<MappedFile>>> pinned;  // in copy order
+            auto pin = [&pinned](const string& path) {
+                unique_ptr<MappedFile> file = pinFile(path);
+                if (file) pinned.emplace_back(path, move(file));
+            };
+            string journal;
+            size_t journalAt;  // journal is copied after pinned[journalAt - 1]
+            bool hasJournal = false;
+            long long millis;
+            {
+                lock_guard<mutex> compactionLock(compactionMutex);
+                error_code ec;
+                for (filesystem::directory_iterator it(SEGMENT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+                    if (it->path().extension() == ".bin") pin(it->path().string());
+                }
+                for (const auto& path : archiveFiles()) {
+                    pin(path);
+                }
+                {
+                    lock_guard<recursive_mutex> lock(stateMutex);
+                    result.lsn = nextLsn - 1;
+                    millis = wallClockMillis();
+                    persistence.flushNow();
+                    pin(ROTATED_JOURNAL_FILE);
+                    // Rotation also runs under stateMutex, so the journal holds still here.
+                    MappedFile live(JOURNAL_FILE);
+                    if (live.isOpen()) {
+                        journal.assign(live.data(), journalPrefixThrough(live, result.lsn));
+                        hasJournal = true;
+                    }
+                    journalAt = pinned.size();
+                }
+                pin("customer_accounts.txt");
+                // The manifest goes last: a backup without one is incomplete.
+                pin(MANIFEST_FILE);
+            }
+
+            IoThrottle throttle(storageConfig.compactionBytesPerSecond);
+            filesystem::create_directories(dir / SEGMENT_DIR);
+            filesystem::create_directories(dir / ARCHIVE_DIR);
+            for (size_t i = 0; i <= pinned.size(); ++i) {
+                if (i == journalAt && hasJournal) {
+                    writeBackupFile((dir / JOURNAL_FILE).string(), journal.data(), journal.size(), throttle);
+                    result.bytesCopied += static_cast<long long>(journal.size());
+                    result.files++;
+                }
+                if (i < pinned.size()) {
+                    result.bytesCopied += backupFile(*pinned[i].second, (dir / pinned[i].first).string(), throttle,
+                                                     result.files);
+                }
+            }
+            writeFileAtomically((dir / "backup.txt").string(),
+                                to_string(result.lsn) + "|" + to_string(millis) + "\n");
+            syncDirectory((dir / SEGMENT_DIR).string());
+            syncDirectory((dir / ARCHIVE_DIR).string());
+            syncDirectory(dir.string());
+            result.succeeded = true;
+        } catch (const exception& ex) {
+            result.error = ex.what();
+        }
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        lock_guard<mutex> lock(backupMutex);
+        backupState = result;
+    }
+
+    // Engines keep the whole store resident, so there are no segments to page in.
+    void loadFromEngine() {
+        long long savedId = engine->load([this](Reservation&& res) {
+            noteReservationId(res.id);
+            addResident(move(res));
+        });
+        nextReservationId = max(nextReservationId, savedId);
+        persistence.open(PersistedFile::Log, "logs.txt");
+    }
+
+    // Ends a mutation: releases stateMutex, then waits until the changes are as
+    // durable as the backend promises. Engines write here, once per operation.
+    void commitChanges(unique_lock<recursive_mutex>& lock, uint64_t ticket) {
+        if (engine) {
+            engine->commit(reservations, nextReservationId);
+            lock.unlock();
+            return;
+        }
+        lock.unlock();
+        if (ticket != 0) {
+            persistence.waitDurable(ticket);
+        }
+    }
+
+    void requireJournalBackend(const string& feature) const {
+        if (engine) {
+            throw ReservationException(feature + " need the journal storage backend.");
+        }
+    }
+
+    void requireWritable() const {
+        if (storageConfig.follower) {
+            throw ReservationException("This is a read-only follower. Make changes on the primary.");
+        }
+    }
+
+    // Applies the complete records in data and returns how many bytes they span.
+    // firstLsn receives the first record's LSN. A record past nextLsn means part of
+    // a rotated journal was never seen; applying stops there until the checkpoint
+    // that covers the gap has been reloaded.
+    size_t applyFollowerRecords(const char* data, size_t size, long long& firstLsn) {
+        return scanJournal(data, size, [&](string_view payload) {
+            if (checkFormatHeader(payload, JOURNAL_TAG, JOURNAL_FORMAT_VERSION)) {
+                return true;
+            }
+            size_t bar = payload.find('|');
+            long long lsn;
+            if (!parseInteger(payload.substr(0, bar), lsn)) {
+                skipMalformedRecord(JOURNAL_FILE, payload);
+                return true;
+            }
+            if (firstLsn < 0) {
+                firstLsn = lsn;
+            }
+            if (lsn < nextLsn) {
+                return true;
+            }
+            if (lsn > nextLsn) {
+                follower.stalled = true;
+                follower.reloadAtLsn = max(follower.reloadAtLsn, lsn - 1);
+                return false;
+            }
+            if (!replayJournalRecord(string(payload), checkpointedLsn)) {
+                skipMalformedRecord(JOURNAL_FILE, payload);
+                return true;
+            }
+            if (payload.substr(bar + 1, 2) == "T|") {
+                parseInteger(payload.substr(bar + 3), follower.primaryClockMillis);
+            }
+            return true;
+        });
+    }
+
+    // Reads whatever the primary has appended to the tailed journal since the last
+    // call and applies it.
+    void readFollowerJournal() {
+        if (!follower.journal.is_open()) {
+            return;
+        }
+        follower.journal.clear();  // a previous read stopped at end of file
+        char buffer[64 * 1024];
+        while (!follower.stalled) {
+            follower.journal.read(buffer, sizeof(buffer));
+            streamsize got = follower.journal.gcount();
+            if (got <= 0) {
+                break;
+            }
+            follower.readBytes += got;
+            follower.pending.append(buffer, static_cast<size_t>(got));
+            follower.pending.erase(0, applyFollowerRecords(follower.pending.data(), follower.pending.size(),
+                                                           follower.firstLsn));
+        }
+    }
+
+    void openFollowerJournal() {
+        follower.journal.close();
+        follower.journal.clear();
+        follower.journal.open(JOURNAL_FILE, ios::binary);
+        follower.pending.clear();
+        follower.readBytes = 0;
+        follower.firstLsn = -1;
+    }
+
+    // Follower counterpart of loadReservations: the same manifest and journals, but
+    // only read, never migrated, truncated or checkpointed, since the primary owns
+    // them. Also used to start over from each new checkpoint.
+    void loadFollower() {
+        reservations.clear();
+        idIndex.clear();
+        customerIndex.clear();
+        unloadedIds.clear();
+        phoneIndex.clear();
+        timeIndex.clear();
+        unloadedSegmentsIndexed = false;
+        archivedIds.clear();
+        archiveIndexed = false;
+        segments.clear();
+        long long snapshotLsn = 0;
+        loadManifest(snapshotLsn);
+        for (const auto& entry : segments) {
+            if (inActiveWindow(entry.first)) {
+                touchSegment(entry.first);
+            }
+        }
+        nextLsn = snapshotLsn + 1;
+        checkpointedLsn = snapshotLsn;
+        follower.reloadAtLsn = -1;
+        follower.stalled = false;
+        {
+            MappedFile rotated(ROTATED_JOURNAL_FILE);
+            long long rotatedFirstLsn = -1;
+            if (rotated.isOpen()) {
+                applyFollowerRecords(rotated.data(), rotated.size(), rotatedFirstLsn);
+            }
+        }
+        openFollowerJournal();
+        readFollowerJournal();
+    }
+
+    // One replication step: applies new records, follows the primary onto a new
+    // journal after a checkpoint, and reloads once the manifest covers what was
+    // applied from the old one.
+    void pollFollower() {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        if (follower.reloadAtLsn >= 0 && manifestSnapshotLsn() >= follower.reloadAtLsn) {
+            loadFollower();
+        }
+        readFollowerJournal();
+        error_code ec;
+        uintmax_t size = filesystem::file_size(JOURNAL_FILE, ec);
+        if (!ec && !follower.stalled) {
+            long long first = firstJournalRecordLsn(JOURNAL_FILE);
+            if (first >= 0 && follower.firstLsn < 0) {
+                // Either the first record arrived after the read above, or the file was replaced.
+                readFollowerJournal();
+            }
+            if (static_cast<long long>(size) < follower.readBytes || (first >= 0 && first != follower.firstLsn)) {
+                // Rotated. The old file, still open here, holds everything up to the rotation.
+                readFollowerJournal();
+                follower.reloadAtLsn = max(follower.reloadAtLsn, nextLsn - 1);
+                openFollowerJournal();
+                readFollowerJournal();
+                size = filesystem::file_size(JOURNAL_FILE, ec);
+            }
+        }
+        long long now = wallClockMillis();
+        if (!follower.stalled && !ec && follower.pending.empty() && static_cast<long long>(size) <= follower.readBytes) {
+            follower.caughtUpMillis = now;
+        }
+        follower.error.clear();
+    }
+
+    // Polls every followerPollMillis. Errors are reported once, not on every poll.
+    void runFollower() {
+        unique_lock<mutex> lock(checkpointMutex);
+        while (!stopping) {
+            checkpointSignal.wait_for(lock, chrono::milliseconds(storageConfig.followerPollMillis),
+                                      [this] { return stopping; });
+            if (stopping) {
+                break;
+            }
+            lock.unlock();
+            try {
+                pollFollower();
+            } catch (const exception& ex) {
+                lock_guard<recursive_mutex> stateLock(stateMutex);
+                if (follower.error != ex.what()) {
+                    cerr << "Error: Unable to apply the primary's journal: " << ex.what() << endl;
+                }
+                follower.error = ex.what();
+            }
+            lock.lock();
+        }
+    }
+
+public:
+    ~ReservationManager() {
+        if (backupThread.joinable()) {
+            backupThread.join();
+        }
+        {
+            lock_guard<mutex> lock(checkpointMutex);
+            stopping = true;
+        }
+        checkpointSignal.notify_one();
+        if (checkpointThread.joinable()) {
+            checkpointThread.join();
+        }
+    }
+
+    bool reservationIdExists(long long id, long long excludeId = -1) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        if (id < 0 || id == excludeId) {
+            return false;
+        }
+        return findReservationIndex(id) >= 0 || !findUnloadedSegment(id).empty() || archiveContainsId(id);
+    }
 
-        ifstream idFile("next_id.txt");
-        if (idFile.is_open()) {
-            int savedId;
-            if (idFile >> savedId) {
-                nextReservationId = max(nextReservationId, savedId);
+    // The archive is read once, on the first check; archiving keeps archivedIds in
+    // step from then on, adding IDs as their segments are detached.
+    bool archiveContainsId(long long id) {
+        if (!archiveIndexed) {
+            for (const auto& path : archiveFiles()) {
+                string month = filesystem::path(path).stem().string();
+                readArchiveFile(path, [&](const ArchivedReservation& record) { archivedIds.add(record.id, month); });
             }
-            idFile.close();
+            archiveIndexed = true;
         }
+        return !archivedIds.find(id).empty();
     }
 
-public:
-    bool reservationIdExists(const string& id, const string& excludeId = "") {
-        string upperId = toUpperCase(id);
-        string upperExcludeId = toUpperCase(excludeId);
-        for (const auto& res : reservations) {
-            if (res.id == upperId && res.id != upperExcludeId) {
-                return true;
-            }
+    // Reads the archive on demand; an empty customerName lists everyone.
+    void viewArchivedReservations(const string& customerName = "") {
+        cout << "\n--- Archived Reservations ---\n";
+        size_t shown = 0;
+        for (const auto& path : archiveFiles()) {
+            readArchiveFile(path, [&](const ArchivedReservation& record) {
+                if (!customerName.empty() && record.customerName != customerName) {
+                    return;
+                }
+                if (shown++ == 0) {
+                    cout << "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
+                }
+                cout << formatReservationId(record.id) << "\t" << record.customerName << "\t" << record.partySize << "\t"
+                     << unpackDate(record.date) << "\t" << unpackTime(record.time) << "\t" << record.phoneNumber
+                     << "\t" << (record.tableNumber + 1) << "\n";
+            });
+        }
+        if (shown == 0) {
+            cout << "No archived reservations.\n";
         }
-        return false;
     }
 
     static ReservationManager& getInstance() {
@@ -228,6 +4761,11 @@ public:
         return *instance;
     }
 
+    // Shuts the instance down; the next getInstance() loads the store again.
+    static void resetInstance() {
+        instance.reset();
+    }
+
     void logLogin(const string& role, const string& username, const string& password) {
         string timestamp = getCurrentTimestamp();
         ostringstream logEntry;
@@ -278,27 +4816,178 @@ public:
         writeLogToFile(logEntry.str());
     }
 
-    void viewTableAvailability() {
-        for (int i = 0; i < tables.size(); ++i) {
-            cout << "Table " << i + 1 << " is " << (tables[i] ? "AVAILABLE" : "BOOKED") << endl;
+    // Tables at one date and time. The reservation movingId, if given, is about to
+    // move there, so its own table counts as available.
+    void viewTableAvailability(const string& date, const string& time, long long movingId = -1) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        int skipIndex = movingId >= 0 ? locateReservation(movingId) : -1;
+        for (int i = 0; i < TABLE_COUNT; ++i) {
+            cout << "Table " << i + 1 << " is " << (tableBookedAt(date, time, i, skipIndex) ? "BOOKED" : "AVAILABLE")
+                 << endl;
         }
     }
 
     bool hasReservations(const string& customerName) {
-        for (const auto& res : reservations) {
-            if (res.customerName == customerName) {
-                return true;
-            }
+        lock_guard<recursive_mutex> lock(stateMutex);
+        indexUnloadedSegments();
+        return customerIndex.contains(customerName);
+    }
+
+    // Copies reservation id, loading its segment if needed; null when it is not stored.
+    unique_ptr<Reservation> getReservation(long long id) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        int index = locateReservation(id);
+        if (index < 0) {
+            return nullptr;
+        }
+        return unique_ptr<Reservation>(new Reservation(reservations[index]));
+    }
+
+    // Whether anything is stored, without reading any segment.
+    bool hasStoredReservations() {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        if (!reservations.empty()) {
+            return true;
+        }
+        for (const auto& entry : segments) {
+            if (!entry.second.loaded && entry.second.onDisk && entry.second.records > 0) return true;
         }
         return false;
     }
 
-    vector<Reservation> getAllReservations() const {
-        return reservations;
+    vector<Reservation> getCustomerReservations(const string& customerName) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        vector<Reservation> found;
+        forEachIndexedReservation(customerIndex, customerName, [&found](const Reservation& res) {
+            found.push_back(res);
+            return true;
+        });
+        return found;
+    }
+
+    size_t phoneIndexBytes() {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        return phoneIndex.memoryBytes();
+    }
+
+    // Every stored reservation made with phone (XXX-XXX-XXXX).
+    vector<Reservation> findReservationsByPhone(const string& phone) {
+        uint64_t key;
+        if (!packPhoneNumber(phone, key)) {
+            throw ReservationException("Invalid phone number format. Use XXX-XXX-XXXX.");
+        }
+        lock_guard<recursive_mutex> lock(stateMutex);
+        vector<Reservation> found;
+        forEachIndexedReservation(phoneIndex, key, [&found](const Reservation& res) {
+            found.push_back(res);
+            return true;
+        });
+        return found;
+    }
+
+    vector<Reservation> getAllReservations() {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        vector<Reservation> all;
+        forEachStoredReservation([&all](const Reservation& res) {
+            all.push_back(res);
+            return true;
+        });
+        return all;
+    }
+
+    // Streams the matching reservations to writer without copying the store. With a
+    // customer, only that customer's reservations are visited; with a date range,
+    // only the days inside it, in date and time order. Returns the rows written.
+    size_t exportReservations(const ExportFilter& filter, ExportWriter& writer) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        if (!filter.customerName.empty()) {
+            forEachIndexedReservation(customerIndex, filter.customerName, [&](const Reservation& res) {
+                if (filter.matches(res)) writer.write(res);
+                return true;
+            });
+            writer.finish();
+            return writer.rows();
+        }
+        if (!filter.fromDate.empty() || !filter.toDate.empty()) {
+            forEachReservationBetween(filter.fromDate, filter.toDate, [&writer](const Reservation& res) {
+                writer.write(res);
+                return true;
+            });
+            writer.finish();
+            return writer.rows();
+        }
+        forEachStoredReservation([&writer](const Reservation& res) {
+            writer.write(res);
+            return true;
+        });
+        writer.finish();
+        return writer.rows();
+    }
+
+    // One day's reservations in time order, with the number of guests expected.
+    void viewDaySheet(const string& date) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        cout << "\n--- Day Sheet for " << date << " ---\n";
+        ExportWriter writer(cout, ExportFormat::Table);
+        long long guests = 0;
+        forEachReservationBetween(date, date, [&](const Reservation& res) {
+            writer.write(res);
+            guests += res.partySize;
+            return true;
+        });
+        writer.finish();
+        if (writer.rows() == 0) {
+            cout << "No reservations found.\n";
+            return;
+        }
+        cout << writer.rows() << " reservations, " << guests << " guests\n";
+    }
+
+    // Reservations and guests per day from fromDate to toDate (inclusive; empty for
+    // no bound).
+    void viewReservationReport(const string& fromDate, const string& toDate) {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        cout << "\n--- Reservations Report ---\n";
+        string day;
+        size_t count = 0, totalCount = 0;
+        long long guests = 0, totalGuests = 0;
+        bool headerShown = false;
+        auto printDay = [&]() {
+            if (count == 0) return;
+            if (!headerShown) {
+                cout << "Date\t\tReservations\tGuests\n";
+                headerShown = true;
+            }
+            cout << day << "\t" << count << "\t\t" << guests << "\n";
+        };
+        forEachReservationBetween(fromDate, toDate, [&](const Reservation& res) {
+            if (res.date != day) {
+                printDay();
+                day = res.date;
+                count = 0;
+                guests = 0;
+            }
+            count++;
+            totalCount++;
+            guests += res.partySize;
+            totalGuests += res.partySize;
+            return true;
+        });
+        printDay();
+        if (totalCount == 0) {
+            cout << "No reservations found.\n";
+            return;
+        }
+        cout << "Total\t\t" << totalCount << "\t\t" << totalGuests << "\n";
     }
 
     int reserveTable(const string& customerName, const string& phoneNumber,
                     int partySize, const string& date, const string& time, int tableNumber) {
+        requireWritable();
+        unique_lock<recursive_mutex> lock(stateMutex);
+        if (!validateCustomerName(customerName)) {
+            throw ReservationException(INVALID_NAME_MESSAGE);
+        }
         if (!validatePhoneNumber(phoneNumber)) {
             throw ReservationException("Invalid phone number format. Use XXX-XXX-XXXX.");
         }
@@ -311,79 +5000,96 @@ public:
         if (!validateTime(time, date)) {
             throw ReservationException("Invalid time format (use HH:MM) or time is in the past for today.");
         }
-        if (tableNumber < 0 || tableNumber >= tables.size()) {
+        if (tableNumber < 0 || tableNumber >= TABLE_COUNT) {
             throw ReservationException("Invalid table number. Must be between 1 and 10.");
         }
-        if (!tables[tableNumber]) {
+        if (tableBookedAt(date, time, tableNumber)) {
             throw ReservationException("Selected table is already booked.");
         }
-        tables[tableNumber] = false;
 
         // Generate new reservation ID
-        string reservationId = "ID " + to_string(nextReservationId) + "A";
-        while (reservationIdExists(reservationId)) {
-            nextReservationId++;
-            reservationId = "ID " + to_string(nextReservationId) + "A";
+        if (nextReservationId == LLONG_MAX) {
+            throw ReservationException("No reservation IDs left to allocate.");
         }
-        nextReservationId++; // Increment for the next reservation
+        long long reservationId = nextReservationId++;
 
-        reservations.emplace_back(reservationId, customerName, phoneNumber, partySize, date, time, tableNumber);
-        saveReservations();
+        markDirty(date);
+        addResident(Reservation(reservationId, customerName, phoneNumber, partySize, date, time, tableNumber));
+        uint64_t ticket = appendJournal("R|" + formatReservationFields(reservations.back()));
+        commitChanges(lock, ticket);
         logReservationAction("Customer", customerName, "Reserved table",
                             "#" + to_string(tableNumber + 1) + " for " + to_string(partySize) + " on " + date + " at " + time,
-                            reservationId, customerName, phoneNumber, partySize, date, time, tableNumber);
+                            formatReservationId(reservationId), customerName, phoneNumber, partySize, date, time,
+                            tableNumber);
         return tableNumber;
     }
 
+    // Commits one batch of validated import rows. A row whose table is already booked
+    // at its date and time, by a stored reservation or an earlier row, is marked as a
+    // conflict by the same tableBookedAt rule reserveTable applies; the rest get fresh
+    // IDs and share a single durability wait.
+    void commitImportBatch(vector<ImportRow>& rows) {
+        requireWritable();
+        unique_lock<recursive_mutex> lock(stateMutex);
+        uint64_t ticket = 0;
+        for (auto& row : rows) {
+            if (!row.error.empty()) {
+                continue;
+            }
+            if (tableBookedAt(row.res.date, row.res.time, row.res.tableNumber)) {
+                row.conflict = true;
+                row.error = "Table " + to_string(row.res.tableNumber + 1) + " is already booked on " + row.res.date +
+                            " at " + row.res.time + ".";
+                continue;
+            }
+            if (nextReservationId == LLONG_MAX) {
+                throw ReservationException("No reservation IDs left to allocate.");
+            }
+            row.res.id = nextReservationId++;
+            markDirty(row.res.date);
+            ticket = appendJournal("R|" + formatReservationFields(row.res));
+            addResident(move(row.res));
+        }
+        commitChanges(lock, ticket);
+    }
+
     void cancelReservation(const string& reservationId, const string& customerName) {
-        string upperId = toUpperCase(reservationId);
-        if (!validateReservationId(upperId)) {
+        requireWritable();
+        unique_lock<recursive_mutex> lock(stateMutex);
+        long long id;
+        if (!parseReservationId(reservationId, id)) {
             throw ReservationException("Invalid reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
         }
-        bool hasReservation = false;
-        int tableIndex = -1;
-        string phoneNumber, date, time;
-        int partySize;
-        for (const auto& res : reservations) {
-            if (res.id == upperId) {
-                hasReservation = true;
-                tableIndex = res.tableNumber;
-                phoneNumber = res.phoneNumber;
-                partySize = res.partySize;
-                date = res.date;
-                time = res.time;
-                break;
-            }
-        }
-        if (!hasReservation) {
+        int index = locateReservation(id);
+        if (index < 0) {
             throw ReservationException("No reservation to cancel.");
         }
-        tables[tableIndex] = true;
-        auto it = reservations.begin();
-        while (it != reservations.end()) {
-            if (it->id == upperId) {
-                it = reservations.erase(it);
-            } else {
-                ++it;
-            }
-        }
-        saveReservations();
-        logReservationAction("Customer", customerName, "Cancelled reservation", "ID " + upperId,
-                            upperId, customerName, phoneNumber, partySize, date, time, tableIndex);
+        int tableIndex = reservations[index].tableNumber;
+        string phoneNumber = reservations[index].phoneNumber;
+        int partySize = reservations[index].partySize;
+        string date = reservations[index].date;
+        string time = reservations[index].time;
+        markDirty(date);
+        removeResidentAt(index);
+        string idText = formatReservationId(id);
+        uint64_t ticket = appendJournal("C|" + idText);
+        commitChanges(lock, ticket);
+        logReservationAction("Customer", customerName, "Cancelled reservation", "ID " + idText,
+                            idText, customerName, phoneNumber, partySize, date, time, tableIndex);
     }
 
     void viewCustomerReservations(const string& customerName) {
+        lock_guard<recursive_mutex> lock(stateMutex);
         cout << "\n--- Your Reservations ---\n";
         bool hasReservations = false;
-        for (const auto& res : reservations) {
-            if (res.customerName == customerName) {
-                cout << "ID: " << res.id << ", Name: " << res.customerName
-                     << ", Contact: " << res.phoneNumber << ", Party Size: " << res.partySize
-                     << ", Date: " << res.date << ", Time: " << res.time
-                     << ", Table: " << res.tableNumber + 1 << endl;
-                hasReservations = true;
-            }
-        }
+        forEachIndexedReservation(customerIndex, customerName, [&](const Reservation& res) {
+            cout << "ID: " << formatReservationId(res.id) << ", Name: " << res.customerName
+                 << ", Contact: " << res.phoneNumber << ", Party Size: " << res.partySize
+                 << ", Date: " << res.date << ", Time: " << res.time
+                 << ", Table: " << res.tableNumber + 1 << "\n";
+            hasReservations = true;
+            return true;
+        });
         if (!hasReservations) {
             cout << "No reservation to view.\n";
         }
@@ -392,30 +5098,29 @@ public:
     void updateReservation(const string& reservationId, const string& customerName,
                            const string& newId, const string& newName, const string& newPhone, int newPartySize,
                            const string& newDate, const string& newTime, int newTableIndex) {
-        string upperId = toUpperCase(reservationId);
-        string upperNewId = newId == "0" ? "0" : toUpperCase(newId);
-        if (!validateReservationId(upperId)) {
+        requireWritable();
+        unique_lock<recursive_mutex> lock(stateMutex);
+        long long id;
+        if (!parseReservationId(reservationId, id)) {
             throw ReservationException("Invalid reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
         }
-        bool hasReservation = false;
-        for (const auto& res : reservations) {
-            if (res.id == upperId) {
-                hasReservation = true;
-                break;
-            }
-        }
-        if (!hasReservation) {
+        int index = locateReservation(id);
+        if (index < 0) {
             throw ReservationException("No reservation to update.");
         }
 
-        if (upperNewId != "0") {
-            if (!validateReservationId(upperNewId)) {
+        long long parsedNewId = -1;
+        if (newId != "0") {
+            if (!parseReservationId(newId, parsedNewId)) {
                 throw ReservationException("Invalid new reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
             }
-            if (reservationIdExists(upperNewId, upperId)) {
+            if (reservationIdExists(parsedNewId, id)) {
                 throw ReservationException("New reservation ID already exists. Choose a different ID.");
             }
         }
+        if (newName != "0" && !validateCustomerName(newName)) {
+            throw ReservationException(INVALID_NAME_MESSAGE);
+        }
         if (newPhone != "0" && !validatePhoneNumber(newPhone)) {
             throw ReservationException("Invalid phone number format. Use XXX-XXX-XXXX.");
         }
@@ -429,73 +5134,76 @@ public:
             throw ReservationException("Invalid time format (use HH:MM) or time is in the past for today.");
         }
 
-        int oldTableIndex = -1;
-        for (auto& res : reservations) {
-            if (res.id == upperId) {
-                oldTableIndex = res.tableNumber;
-                break;
-            }
-        }
+        int oldTableIndex = reservations[index].tableNumber;
         if (newTableIndex != -1) {
-            if (newTableIndex < 0 || newTableIndex >= tables.size()) {
+            if (newTableIndex < 0 || newTableIndex >= TABLE_COUNT) {
                 throw ReservationException("Invalid new table index.");
             }
-            tables[oldTableIndex] = true;
-            if (!tables[newTableIndex]) {
-                tables[oldTableIndex] = false;
-                throw ReservationException("Selected table is already booked.");
-            }
-            tables[newTableIndex] = false;
         } else {
             newTableIndex = oldTableIndex;
         }
+        string targetDate = newDate != "0" ? newDate : reservations[index].date;
+        string targetTime = newTime != "0" ? newTime : reservations[index].time;
+        if ((newTableIndex != oldTableIndex || targetDate != reservations[index].date ||
+             targetTime != reservations[index].time) &&
+            tableBookedAt(targetDate, targetTime, newTableIndex, index)) {
+            throw ReservationException("Selected table is already booked.");
+        }
+        // Both date segments change when the reservation moves to another day.
+        markDirty(reservations[index].date);
+        if (newDate != "0") {
+            markDirty(newDate);
+        }
 
-        string finalId = upperId;
+        string idText = formatReservationId(id);
+        string finalId = idText;
         string finalName = customerName;
         string finalPhone = "";
         int finalPartySize = 0;
         string finalDate = "";
         string finalTime = "";
-        for (auto& res : reservations) {
-            if (res.id == upperId) {
-                finalPhone = res.phoneNumber;
-                finalPartySize = res.partySize;
-                finalDate = res.date;
-                finalTime = res.time;
-                if (upperNewId != "0") {
-                    res.id = upperNewId;
-                    finalId = upperNewId;
-                }
-                if (newName != "0") {
-                    res.customerName = newName;
-                    finalName = newName;
-                }
-                if (newPhone != "0") {
-                    res.phoneNumber = newPhone;
-                    finalPhone = newPhone;
-                }
-                if (newPartySize != 0) {
-                    res.partySize = newPartySize;
-                    finalPartySize = newPartySize;
-                }
-                if (newDate != "0") {
-                    res.date = newDate;
-                    finalDate = newDate;
-                }
-                if (newTime != "0") {
-                    res.time = newTime;
-                    finalTime = newTime;
-                }
-                res.tableNumber = newTableIndex;
-                break;
-            }
+        string updatedFields;
+        Reservation res = reservations[index];
+        finalPhone = res.phoneNumber;
+        finalPartySize = res.partySize;
+        finalDate = res.date;
+        finalTime = res.time;
+        if (parsedNewId >= 0) {
+            res.id = parsedNewId;
+            finalId = formatReservationId(parsedNewId);
+            noteReservationId(parsedNewId);
+        }
+        if (newName != "0") {
+            res.customerName = newName;
+            finalName = newName;
+        }
+        if (newPhone != "0") {
+            res.phoneNumber = newPhone;
+            finalPhone = newPhone;
+        }
+        if (newPartySize != 0) {
+            res.partySize = newPartySize;
+            finalPartySize = newPartySize;
+        }
+        if (newDate != "0") {
+            res.date = newDate;
+            finalDate = newDate;
         }
-        saveReservations();
-        logReservationAction("Customer", customerName, "Updated reservation", "ID " + upperId,
+        if (newTime != "0") {
+            res.time = newTime;
+            finalTime = newTime;
+        }
+        res.tableNumber = newTableIndex;
+        updatedFields = formatReservationFields(res);
+        replaceResidentAt(index, res);
+        uint64_t ticket = appendJournal("U|" + idText + "|" + updatedFields);
+        commitChanges(lock, ticket);
+        logReservationAction("Customer", customerName, "Updated reservation", "ID " + idText,
                             finalId, finalName, finalPhone, finalPartySize, finalDate, finalTime, newTableIndex);
     }
 
     void viewLogs() {
+        persistence.flushNow();
         cout << "--- System Logs ---\n\n";
         ifstream logFile("logs.txt");
         if (logFile.is_open()) {
@@ -508,10 +5216,251 @@ public:
             cout << "Unable to open log file.\n";
         }
     }
+
+    // Starts a backup of the store as it is now into dir, which must be new or empty,
+    // and returns at once; backupStatus() reports progress and the outcome.
+    void startBackup(const string& dir) {
+        requireWritable();
+        requireJournalBackend("Backups");
+        lock_guard<mutex> lock(backupMutex);
+        if (backupState.running) {
+            throw ReservationException("A backup is already running.");
+        }
+        error_code ec;
+        if (dir.empty() || (filesystem::exists(dir) && !filesystem::is_empty(dir, ec))) {
+            throw ReservationException("Backup directory must be new or empty.");
+        }
+        if (backupThread.joinable()) {
+            backupThread.join();
+        }
+        backupState = BackupStatus();
+        backupState.running = true;
+        backupState.path = dir;
+        backupThread = thread(&ReservationManager::runBackup, this, filesystem::path(dir));
+    }
+
+    BackupStatus backupStatus() {
+        lock_guard<mutex> lock(backupMutex);
+        return backupState;
+    }
+
+    // Blocks until the running backup (if any) has finished.
+    BackupStatus waitForBackup() {
+        thread running;
+        {
+            lock_guard<mutex> lock(backupMutex);
+            running = move(backupThread);
+        }
+        if (running.joinable()) {
+            running.join();
+        }
+        return backupStatus();
+    }
+
+    FollowerStatus followerStatus() {
+        lock_guard<recursive_mutex> lock(stateMutex);
+        FollowerStatus status;
+        status.appliedLsn = nextLsn - 1;
+        status.primaryClockMillis = follower.primaryClockMillis;
+        error_code ec;
+        uintmax_t size = filesystem::file_size(JOURNAL_FILE, ec);
+        status.bytesBehind = static_cast<long long>(follower.pending.size()) +
+                             (ec ? 0 : max(0LL, static_cast<long long>(size) - follower.readBytes));
+        status.awaitingCheckpoint = follower.stalled;
+        if ((status.bytesBehind > 0 || status.awaitingCheckpoint) && follower.caughtUpMillis > 0) {
+            status.lagMillis = max(0LL, wallClockMillis() - follower.caughtUpMillis);
+        }
+        return status;
+    }
+
+    // Runs a compaction on the calling thread and returns its statistics.
+    CompactionStats compactNow() {
+        requireWritable();
+        if (engine) {
+            lock_guard<recursive_mutex> lock(stateMutex);
+            return compactionStats;  // nothing to compact
+        }
+        checkpoint();
+        lock_guard<recursive_mutex> lock(stateMutex);
+        return compactionStats;
+    }
+
+    void viewStorageStatus() {
+        if (engine) {
+            lock_guard<recursive_mutex> lock(stateMutex);
+            cout << "\n--- Storage Status ---\n"
+                 << "Storage backend: " << engine->name() << "\n"
+                 << "Reservations: " << reservations.size() << "\n"
+                 << "On disk: " << engine->diskBytes() << " bytes\n";
+            return;
+        }
+        PersistenceStats stats = persistence.stats();
+        size_t onDisk = 0, resident = 0, idIndexBytes, customerIndexBytes, phoneIndexBytes, timeIndexBytes;
+        double amplification;
+        CompactionStats compaction;
+        {
+            lock_guard<recursive_mutex> lock(stateMutex);
+            for (const auto& entry : segments) {
+                onDisk += entry.second.onDisk ? 1 : 0;
+                resident += entry.second.loaded ? 1 : 0;
+            }
+            idIndexBytes = idIndex.memoryBytes() + unloadedIds.memoryBytes() + archivedIds.memoryBytes();
+            customerIndexBytes = customerIndex.memoryBytes();
+            phoneIndexBytes = phoneIndex.memoryBytes();
+            timeIndexBytes = timeIndex.memoryBytes();
+            amplification = spaceAmplification(storeDiskBytes(), liveBytes());
+            compaction = compactionStats;
+        }
+        size_t archivedRecords = 0, archiveBytes = 0;
+        vector<string> archive = archiveFiles();
+        for (const auto& path : archive) {
+            MappedFile file(path);
+            if (!file.isOpen()) continue;
+            bool columnar = file.size() >= sizeof(ARCHIVE_MAGIC) &&
+                            memcmp(file.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0;
+            archivedRecords += columnar ? ArchiveView(file).size() : BinarySnapshotView(file).size();
+            archiveBytes += file.size();
+        }
+        cout << "\n--- Storage Status ---\n"
+             << "Storage backend: journal\n"
+             << "Durability mode: " << durabilityModeName(storageConfig.durability) << "\n"
+             << "Queued records: " << stats.queuedRecords << " / " << stats.capacity << "\n"
+             << "Oldest queued record: " << stats.oldestQueuedMillis << " ms\n"
+             << "Journal records not yet fsynced: " << stats.unsyncedJournalRecords << "\n"
+             << "Last flush: " << stats.lastFlushMillis << " ms (" << stats.flushes << " flushes)\n"
+             << "Journal size: " << persistence.size(PersistedFile::Journal) << " bytes\n"
+             << "Date segments: " << onDisk << " on disk, " << resident << " resident\n"
+             << "Index memory: ID " << idIndexBytes / 1024 << " KB, customer " << customerIndexBytes / 1024
+             << " KB, phone " << phoneIndexBytes / 1024 << " KB, time " << timeIndexBytes / 1024 << " KB\n"
+             << "Space amplification: " << amplification << "x\n"
+             << "Archive: " << archivedRecords << " reservations in " << archive.size() << " files, " << archiveBytes
+             << " bytes\n";
+        if (compaction.runs > 0) {
+            cout << "Last compaction: " << compaction.amplificationBefore << "x -> " << compaction.amplificationAfter
+                 << "x, " << compaction.foldedRecords << " journal records folded (" << compaction.droppedTombstones
+                 << " tombstones), " << compaction.bytesWritten << " bytes written in " << compaction.lastMillis
+                 << " ms, " << compaction.archivedRecords << " reservations archived\n";
+        }
+        vector<long long> history = historyLsns("checkpoint-", "");
+        cout << "Restore history: " << history.size() << " checkpoints";
+        if (!history.empty()) {
+            cout << " (LSN " << history.front() << " to " << history.back() << ")";
+        }
+        cout << "\n";
+        BackupStatus backup = backupStatus();
+        if (backup.running) {
+            cout << "Backup: running into " << backup.path << "\n";
+        } else if (backup.succeeded) {
+            cout << "Last backup: LSN " << backup.lsn << " into " << backup.path << ", " << backup.files << " files, "
+                 << backup.bytesCopied << " bytes in " << backup.seconds << " s\n";
+        } else if (!backup.error.empty()) {
+            cout << "Last backup into " << backup.path << " failed: " << backup.error << "\n";
+        }
+        if (storageConfig.follower) {
+            FollowerStatus replica = followerStatus();
+            cout << "Follower: applied through LSN " << replica.appliedLsn << ", " << replica.lagMillis << " ms behind, "
+                 << replica.bytesBehind << " journal bytes unapplied";
+            if (replica.primaryClockMillis > 0) {
+                cout << ", primary last wrote at " << formatLocalTime(replica.primaryClockMillis);
+            }
+            cout << (replica.awaitingCheckpoint ? " (waiting for the primary's next checkpoint)" : "") << "\n";
+        }
+    }
 };
 
 unique_ptr<ReservationManager> ReservationManager::instance = nullptr;
 
+// -------- Bulk Import --------
+// Streams a CSV (see "CSV Import") into the store. Rejected rows are written to
+// errors as "Line N: reason"; they never stop the rest of the file.
+ImportStats importReservationsCsv(const string& path, const string& role, const string& username, ostream& errors) {
+    if (!filesystem::is_regular_file(path)) {
+        throw ReservationException("Unable to open " + path + " for reading.");
+    }
+    ReservationManager& manager = ReservationManager::getInstance();
+    ImportStats stats;
+    size_t lineNumber = 0;
+    vector<string_view> lines;
+    vector<size_t> lineNumbers;
+    vector<ImportRow> rows;
+    auto start = chrono::steady_clock::now();
+
+    stats.bytes = forEachLineChunk(path, IMPORT_BATCH_BYTES, [&](const char* data, size_t size) {
+        lines.clear();
+        lineNumbers.clear();
+        string_view chunk(data, size);
+        while (!chunk.empty()) {
+            size_t end = min(chunk.find('\n'), chunk.size());
+            string_view line = chunk.substr(0, end);
+            chunk.remove_prefix(min(end + 1, chunk.size()));
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (++lineNumber == 1 && isImportHeader(line)) {
+                continue;
+            }
+            if (!line.empty()) {
+                lines.push_back(line);
+                lineNumbers.push_back(lineNumber);
+            }
+        }
+
+        rows.assign(lines.size(), ImportRow());
+        runParallel((lines.size() + IMPORT_ROWS_PER_TASK - 1) / IMPORT_ROWS_PER_TASK, [&](size_t task) {
+            size_t end = min(lines.size(), (task + 1) * IMPORT_ROWS_PER_TASK);
+            for (size_t i = task * IMPORT_ROWS_PER_TASK; i < end; ++i) {
+                rows[i].line = lineNumbers[i];
+                validateImportRow(lines[i], rows[i]);
+            }
+        });
+        manager.commitImportBatch(rows);
+
+        for (const auto& row : rows) {
+            if (row.error.empty()) {
+                stats.imported++;
+                continue;
+            }
+            stats.rejected++;
+            stats.conflicts += row.conflict ? 1 : 0;
+            errors << "Line " << row.line << ": " << row.error << "\n";
+        }
+        stats.rows += rows.size();
+    });
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    manager.logReservationAction(role, username, "Imported reservations",
+                                 to_string(stats.imported) + " of " + to_string(stats.rows) + " rows from " + path +
+                                     " (" + to_string(stats.rejected) + " rejected, " + to_string(stats.conflicts) +
+                                     " table conflicts)");
+    return stats;
+}
+
+void printImportSummary(const ImportStats& stats) {
+    cout << "Imported " << stats.imported << " of " << stats.rows << " rows (" << stats.rejected << " rejected, "
+         << stats.conflicts << " table conflicts) in " << stats.seconds << " s, "
+         << static_cast<long long>(stats.rows / max(stats.seconds, 1e-9)) << " rows/s.\n";
+}
+
+// -------- Bulk Export --------
+// Exports to path, or to stdout when path is empty.
+size_t exportReservationsTo(const string& path, ExportFormat format, const ExportFilter& filter) {
+    if (path.empty()) {
+        ExportWriter writer(cout, format);
+        return ReservationManager::getInstance().exportReservations(filter, writer);
+    }
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw ReservationException("Unable to open " + path + " for writing.");
+    }
+    ExportWriter writer(file, format);
+    size_t rows = ReservationManager::getInstance().exportReservations(filter, writer);
+    file.close();
+    if (!file) {
+        throw ReservationException("Unable to write " + path + ".");
+    }
+    return rows;
+}
+
 // -------- Abstraction + Polymorphism --------
 class User {
 protected:
@@ -525,36 +5474,191 @@ public:
     virtual ~User() = default;
 };
 
+// -------- Helper Functions for Customer Accounts --------
+// customer_accounts.txt is an append-only log of "<username>|<password>" lines
+// behind an RSVACCOUNTS header, checksummed like the journal; a later line for
+// the same username wins. Signup appends one line instead of rewriting the file,
+// and the log is compacted once superseded or torn lines make up more than half
+// of it. Files from older versions are migrated to this format on load.
+class CustomerAccountStore {
+    string path;
+    unordered_map<string, string> accounts;
+    size_t logRecords;
+    int fd;
+    size_t scannedBytes;  // log bytes already read; refresh() continues from here
+
+    void openLog() {
+        fd = openAppendDescriptor(path);
+        if (fd < 0) {
+            cerr << "Error: Unable to open " << path << " for writing." << endl;
+            return;
+        }
+        if (fileBytes(path) == 0) {
+            string header = journalLine(formatHeader(ACCOUNTS_TAG, ACCOUNTS_FORMAT_VERSION));
+            writeDescriptor(fd, header.data(), header.size());
+        }
+    }
+
+    void compact() {
+        const string temp = path + ".tmp";
+        {
+            ofstream file(temp, ios::binary | ios::trunc);
+            if (!file.is_open()) {
+                cerr << "Error: Unable to open " << temp << " for writing." << endl;
+                return;
+            }
+            file << journalLine(formatHeader(ACCOUNTS_TAG, ACCOUNTS_FORMAT_VERSION));
+            for (const auto& account : accounts) {
+                file << journalLine(account.first + "|" + account.second);
+            }
+        }
+        if (fd >= 0) {
+            closeDescriptor(fd);
+        }
+        try {
+            commitFile(temp, path);
+            logRecords = accounts.size();
+        } catch (const ReservationException& ex) {
+            cerr << "Error: " << ex.what() << endl;
+        }
+        openLog();
+    }
+
+    // Reads the log from byte `from` on; returns where the intact records end.
+    size_t scan(const MappedFile& file, size_t from) {
+        return from + scanJournal(file.data() + from, file.size() - from, [this](string_view line) {
+            if (checkFormatHeader(line, ACCOUNTS_TAG, ACCOUNTS_FORMAT_VERSION)) {
+                return true;
+            }
+            size_t bar = line.find('|');
+            if (bar == string_view::npos) {
+                return false;
+            }
+            accounts[string(line.substr(0, bar))] = string(line.substr(bar + 1));
+            logRecords++;
+            return true;
+        });
+    }
+
+public:
+    explicit CustomerAccountStore(const string& file) : path(file), logRecords(0), fd(-1), scannedBytes(0) {}
+    ~CustomerAccountStore() {
+        if (fd >= 0) closeDescriptor(fd);
+    }
+    CustomerAccountStore(const CustomerAccountStore&) = delete;
+    CustomerAccountStore& operator=(const CustomerAccountStore&) = delete;
+
+    // A read-only store (a follower's) never migrates, compacts or appends; see refresh().
+    void load(bool readOnly = false) {
+        if (!readOnly) {
+            MigrationStats migration;
+            migrateLegacyAccounts(path, migration);
+        }
+        bool damaged = false;
+        {
+            MappedFile file(path);
+            if (file.isOpen()) {
+                // ~24 bytes per line is a fair guess; it only saves rehashing.
+                accounts.reserve(file.size() / 24);
+                scannedBytes = scan(file, 0);
+                damaged = scannedBytes < file.size();
+            }
+        }
+        if (readOnly) {
+            return;
+        }
+        if (damaged || logRecords > 2 * accounts.size()) {
+            compact();
+        } else {
+            openLog();
+        }
+    }
+
+    bool contains(const string& username) const { return accounts.count(username) > 0; }
+
+    bool matches(const string& username, const string& password) const {
+        auto it = accounts.find(username);
+        return it != accounts.end() && it->second == password;
+    }
+
+    size_t size() const { return accounts.size(); }
+
+    // Picks up accounts another process appended since load(). A log that was
+    // compacted in the meantime no longer lines up with scannedBytes, so it is read
+    // again from the start.
+    void refresh() {
+        MappedFile file(path);
+        if (!file.isOpen()) {
+            return;
+        }
+        size_t end = file.size() >= scannedBytes ? scan(file, scannedBytes) : scannedBytes;
+        if (end == scannedBytes && file.size() != scannedBytes) {
+            accounts.clear();
+            logRecords = 0;
+            end = scan(file, 0);
+        }
+        scannedBytes = end;
+    }
+
+    void add(const string& username, const string& password) {
+        accounts[username] = password;
+        string line = journalLine(username + "|" + password);
+        if (fd < 0 || !writeDescriptor(fd, line.data(), line.size()) || !syncDescriptor(fd)) {
+            cerr << "Error: Unable to write " << path << "." << endl;
+            return;
+        }
+        if (++logRecords > 2 * accounts.size() + 1024) {
+            compact();
+        }
+    }
+};
+
 // Account database
 map<string, string> receptionistAccounts;
-map<string, string> customerAccounts;
+CustomerAccountStore customerAccounts("customer_accounts.txt");
 
-// -------- Helper Functions for Customer Accounts --------
-void saveCustomerAccounts(const map<string, string>& accounts) {
-    ofstream accountsFile("customer_accounts.txt");
-    if (!accountsFile.is_open()) {
-        cerr << "Error: Unable to open customer_accounts.txt for writing." << endl;
-        return;
+// Tells the user, and returns true, when this process is a follower and so cannot
+// change reservations; checked before a menu action asks for any input.
+bool refuseChangeOnFollower() {
+    if (storageConfig.follower) {
+        cout << "This is a read-only follower. Make changes on the primary.\n";
+        return true;
+    }
+    return false;
+}
+
+// Asks for a date and time and shows which tables are free then.
+void promptTableAvailability() {
+    string date, time;
+    while (true) {
+        cout << "Enter date (YYYY-MM-DD, or press Enter for today): ";
+        getline(cin, date);
+        if (date.empty()) date = CURRENT_DATE;
+        if (validateDate(date)) break;
+        cout << "Error: Invalid date format (use YYYY-MM-DD) or date is in the past.\n";
     }
-    for (const auto& account : accounts) {
-        accountsFile << account.first << "|" << account.second << "\n";
+    while (true) {
+        cout << "Enter time (HH:MM in 24-hour format): ";
+        getline(cin, time);
+        if (validateTime(time, date)) break;
+        cout << "Error: Invalid time format (use HH:MM) or time is in the past for today.\n";
     }
-    accountsFile.close();
+    ReservationManager::getInstance().viewTableAvailability(date, time);
 }
 
-void loadCustomerAccounts(map<string, string>& accounts) {
-    ifstream accountsFile("customer_accounts.txt");
-    if (accountsFile.is_open()) {
-        string line;
-        while (getline(accountsFile, line)) {
-            stringstream ss(line);
-            string username, password;
-            getline(ss, username, '|');
-            getline(ss, password);
-            accounts[username] = password;
-        }
-        accountsFile.close();
+// Shows which tables are free where an update would move reservationId. A "0"
+// keeps its current date or time, and its own table counts as free.
+void showTablesForUpdate(const string& reservationId, const string& newDate, const string& newTime) {
+    long long id;
+    unique_ptr<Reservation> res;
+    if (parseReservationId(reservationId, id)) {
+        res = ReservationManager::getInstance().getReservation(id);
+    }
+    if (!res) {
+        return;
     }
+    ReservationManager::getInstance().viewTableAvailability(newDate != "0" ? newDate : res->date,
+                                                           newTime != "0" ? newTime : res->time, id);
 }
 
 // -------- Inheritance for Roles --------
@@ -567,7 +5671,11 @@ public:
             while (!usernameValid) {
                 cout << "Enter username: ";
                 getline(cin, name);
-                if (customerAccounts.count(name)) {
+                if (!validateCustomerName(name)) {
+                    cout << "Error: " << INVALID_NAME_MESSAGE << "\n";
+                    continue;
+                }
+                if (customerAccounts.contains(name)) {
                     cout << "Account already exists. Please choose a different username.\n";
                     continue;
                 }
@@ -575,8 +5683,7 @@ public:
             }
             cout << "Enter password: ";
             getline(cin, password);
-            customerAccounts[name] = password;
-            saveCustomerAccounts(customerAccounts);
+            customerAccounts.add(name, password);
             cout << "Customer account created.\n";
             ReservationManager::getInstance().logLogin("Customer", name, password);
             username = name;
@@ -587,7 +5694,10 @@ public:
                 getline(cin, name);
                 cout << "Enter password: ";
                 getline(cin, password);
-                if (customerAccounts.count(name) && customerAccounts[name] == password) {
+                if (storageConfig.follower && !customerAccounts.matches(name, password)) {
+                    customerAccounts.refresh();  // the account may have been created on the primary
+                }
+                if (customerAccounts.matches(name, password)) {
                     credentialsValid = true;
                     ReservationManager::getInstance().logLogin("Customer", name, password);
                     username = name;
@@ -622,9 +5732,10 @@ public:
                     ReservationManager::getInstance().viewCustomerReservations(username);
                     break;
                 case 2:
-                    ReservationManager::getInstance().viewTableAvailability();
+                    promptTableAvailability();
                     break;
                 case 3: {
+                    if (refuseChangeOnFollower()) break;
                     string phoneNumber, date, time, partySizeInput, tableInput;
                     int partySize, tableNumber;
 
@@ -686,7 +5797,7 @@ public:
                     bool reservationComplete = false;
                     while (!reservationComplete) {
                         cout << "Available tables:\n";
-                        ReservationManager::getInstance().viewTableAvailability();
+                        ReservationManager::getInstance().viewTableAvailability(date, time);
                         cout << "Enter table number to reserve (1-10, or 0 to cancel): ";
                         getline(cin, tableInput);
 
@@ -726,6 +5837,7 @@ public:
                     break;
                 }
                 case 4: {
+                    if (refuseChangeOnFollower()) break;
                     if (!ReservationManager::getInstance().hasReservations(username)) {
                         cout << "No reservations.\n";
                         break;
@@ -739,13 +5851,14 @@ public:
                         getline(cin, reservationId);
                         reservationId = toUpperCase(reservationId);
                         try {
-                            if (!validateReservationId(reservationId)) {
+                            long long numericId;
+                            if (!parseReservationId(reservationId, numericId)) {
                                 throw ReservationException("Invalid reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
                             }
                             bool hasReservation = false;
-                            vector<Reservation> allRes = ReservationManager::getInstance().getAllReservations();
+                            vector<Reservation> allRes = ReservationManager::getInstance().getCustomerReservations(username);
                             for (const auto& res : allRes) {
-                                if (res.id == reservationId && res.customerName == username) {
+                                if (res.id == numericId && res.customerName == username) {
                                     hasReservation = true;
                                     break;
                                 }
@@ -764,7 +5877,10 @@ public:
                     while (true) {
                         cout << "Enter new name (or 0 to keep current): ";
                         getline(cin, newName);
-                        break;
+                        if (newName == "0" || validateCustomerName(newName)) break;
+                        cout << "Error: " << INVALID_NAME_MESSAGE << "\n";
+                        ReservationManager::getInstance().logError("Customer", username, "Failed to update reservation",
+                                                                 INVALID_NAME_MESSAGE, reservationId, newName);
                     }
 
                     while (true) {
@@ -825,7 +5941,7 @@ public:
 
                     while (true) {
                         cout << "Table options: 0 to keep current, or enter a specific table number (1-10):\n";
-                        ReservationManager::getInstance().viewTableAvailability();
+                        showTablesForUpdate(reservationId, newDate, newTime);
                         cout << "Choice: ";
                         getline(cin, newTableChoiceInput);
                         if (!validateNumericInput(newTableChoiceInput, newTableChoice, 0, 10)) {
@@ -863,6 +5979,7 @@ public:
                     break;
                 }
                 case 5: {
+                    if (refuseChangeOnFollower()) break;
                     if (!ReservationManager::getInstance().hasReservations(username)) {
                         cout << "No reservations.\n";
                         break;
@@ -930,39 +6047,63 @@ public:
             string input;
             int choice;
             cout << "\n[Receptionist Menu - " << username << "]\n";
-            cout << "1. View Reservations\n2. View Table Availability\n3. Exit\nChoice: ";
+            cout << "1. View Reservations\n2. View Table Availability\n3. Find Reservations by Phone\n"
+                 << "4. View Day Sheet\n5. Exit\nChoice: ";
             getline(cin, input);
 
-            if (!validateNumericInput(input, choice, 1, 3)) {
-                cout << "Invalid choice. Please enter a single number between 1 and 3.\n";
+            if (!validateNumericInput(input, choice, 1, 5)) {
+                cout << "Invalid choice. Please enter a single number between 1 and 5.\n";
                 continue;
             }
 
             switch (choice) {
                 case 1: {
                     cout << "\n--- Current Reservations ---\n";
-                    vector<Reservation> allReservations = ReservationManager::getInstance().getAllReservations();
-                   
-                    if (allReservations.empty()) {
+                    ExportWriter writer(cout, ExportFormat::Table);
+                    if (ReservationManager::getInstance().exportReservations(ExportFilter(), writer) == 0) {
                         cout << "No reservations found.\n";
-                    } else {
-                        cout << "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
-                        for (const auto& res : allReservations) {
-                            cout << res.id << "\t"
-                                 << res.customerName << "\t"
-                                 << res.partySize << "\t"
-                                 << res.date << "\t"
-                                 << res.time << "\t"
-                                 << res.phoneNumber << "\t"
-                                 << (res.tableNumber + 1) << endl;
-                        }
                     }
                     break;
                 }
                 case 2:
-                    ReservationManager::getInstance().viewTableAvailability();
+                    promptTableAvailability();
                     break;
                 case 3: {
+                    string phoneNumber;
+                    cout << "Enter caller's phone number (e.g., 123-456-7890): ";
+                    getline(cin, phoneNumber);
+                    try {
+                        vector<Reservation> found = ReservationManager::getInstance().findReservationsByPhone(phoneNumber);
+                        cout << "\n--- Reservations for " << phoneNumber << " ---\n";
+                        if (found.empty()) {
+                            cout << "No reservations found.\n";
+                            break;
+                        }
+                        ExportWriter writer(cout, ExportFormat::Table);
+                        for (const auto& res : found) {
+                            writer.write(res);
+                        }
+                        writer.finish();
+                    } catch (const ReservationException& ex) {
+                        cout << "Error: " << ex.what() << endl;
+                        ReservationManager::getInstance().logError("Receptionist", username, "Failed to look up phone number",
+                                                                 ex.what(), "", "", phoneNumber);
+                    }
+                    break;
+                }
+                case 4: {
+                    string date;
+                    while (true) {
+                        cout << "Enter date (YYYY-MM-DD, or press Enter for today): ";
+                        getline(cin, date);
+                        if (date.empty()) date = CURRENT_DATE;
+                        if (isDateShaped(date)) break;
+                        cout << "Invalid date format. Use YYYY-MM-DD.\n";
+                    }
+                    ReservationManager::getInstance().viewDaySheet(date);
+                    break;
+                }
+                case 5: {
                     string logout;
                     cout << "Logout? (Y/N or Yes/No): ";
                     getline(cin, logout);
@@ -992,11 +6133,17 @@ public:
             cout << "4. Update Reservation\n";
             cout << "5. Cancel Reservation\n";
             cout << "6. Create Receptionist Account\n";
-            cout << "7. Log Out\nChoice: ";
+            cout << "7. View Storage Status\n";
+            cout << "8. View Archived Reservations\n";
+            cout << "9. Import Reservations from CSV\n";
+            cout << "10. Export Reservations\n";
+            cout << "11. Back Up Reservations\n";
+            cout << "12. Reservations Report\n";
+            cout << "13. Log Out\nChoice: ";
             getline(cin, input);
 
-            if (!validateNumericInput(input, choice, 1, 7)) {
-                cout << "Invalid choice. Please enter a single number between 1 and 7.\n";
+            if (!validateNumericInput(input, choice, 1, 13)) {
+                cout << "Invalid choice. Please enter a single number between 1 and 13.\n";
                 continue;
             }
 
@@ -1006,30 +6153,18 @@ public:
                     break;
                 case 2: {
                     cout << "\n--- Current Reservations ---\n";
-                    vector<Reservation> allReservations = ReservationManager::getInstance().getAllReservations();
-                   
-                    if (allReservations.empty()) {
+                    ExportWriter writer(cout, ExportFormat::Table);
+                    if (ReservationManager::getInstance().exportReservations(ExportFilter(), writer) == 0) {
                         cout << "No reservations found.\n";
-                    } else {
-                        cout << "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
-                        for (const auto& res : allReservations) {
-                            cout << res.id << "\t"
-                                 << res.customerName << "\t"
-                                 << res.partySize << "\t"
-                                 << res.date << "\t"
-                                 << res.time << "\t"
-                                 << res.phoneNumber << "\t"
-                                 << (res.tableNumber + 1) << endl;
-                        }
                     }
                     break;
                 }
                 case 3:
-                    ReservationManager::getInstance().viewTableAvailability();
+                    promptTableAvailability();
                     break;
                 case 4: {
-                    vector<Reservation> allReservations = ReservationManager::getInstance().getAllReservations();
-                    if (allReservations.empty()) {
+                    if (refuseChangeOnFollower()) break;
+                    if (!ReservationManager::getInstance().hasStoredReservations()) {
                         cout << "No reservations.\n";
                         break;
                     }
@@ -1043,34 +6178,25 @@ public:
                         getline(cin, reservationId);
                         reservationId = toUpperCase(reservationId);
                         try {
-                            if (!validateReservationId(reservationId)) {
+                            long long numericId;
+                            if (!parseReservationId(reservationId, numericId)) {
                                 throw ReservationException("Invalid reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
                             }
-                            bool hasReservation = false;
-                            for (const auto& res : allReservations) {
-                                if (res.id == reservationId) {
-                                    hasReservation = true;
-                                    customerName = res.customerName;
-                                    break;
-                                }
-                            }
-                            if (!hasReservation) {
+                            unique_ptr<Reservation> found = ReservationManager::getInstance().getReservation(numericId);
+                            if (!found) {
                                 throw ReservationException("Reservation ID not found.");
                             }
+                            const Reservation& res = *found;
+                            customerName = res.customerName;
                             cout << "\n--- Reservation to Update ---\n";
                             cout << "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
-                            for (const auto& res : allReservations) {
-                                if (res.id == reservationId) {
-                                    cout << res.id << "\t"
-                                         << res.customerName << "\t"
-                                         << res.partySize << "\t"
-                                         << res.date << "\t"
-                                         << res.time << "\t"
-                                         << res.phoneNumber << "\t"
-                                         << (res.tableNumber + 1) << endl;
-                                    break;
-                                }
-                            }
+                            cout << formatReservationId(res.id) << "\t"
+                                 << res.customerName << "\t"
+                                 << res.partySize << "\t"
+                                 << res.date << "\t"
+                                 << res.time << "\t"
+                                 << res.phoneNumber << "\t"
+                                 << (res.tableNumber + 1) << endl;
                             break;
                         } catch (const ReservationException& ex) {
                             cout << "Error: " << ex.what() << endl;
@@ -1085,10 +6211,12 @@ public:
                         newId = toUpperCase(newId);
                         if (newId == "0") break;
                         try {
-                            if (!validateReservationId(newId)) {
+                            long long numericNewId;
+                            if (!parseReservationId(newId, numericNewId)) {
                                 throw ReservationException("Invalid new reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
                             }
-                            if (ReservationManager::getInstance().reservationIdExists(newId, reservationId)) {
+                            if (ReservationManager::getInstance().reservationIdExists(
+                                    numericNewId, parseReservationIdOrInvalid(reservationId))) {
                                 throw ReservationException("New reservation ID already exists. Choose a different ID.");
                             }
                             break;
@@ -1102,7 +6230,10 @@ public:
                     while (true) {
                         cout << "Enter new name (or 0 to keep current): ";
                         getline(cin, newName);
-                        break;
+                        if (newName == "0" || validateCustomerName(newName)) break;
+                        cout << "Error: " << INVALID_NAME_MESSAGE << "\n";
+                        ReservationManager::getInstance().logError("Admin", username, "Failed to update reservation",
+                                                                 INVALID_NAME_MESSAGE, reservationId, newName);
                     }
 
                     while (true) {
@@ -1163,7 +6294,7 @@ public:
 
                     while (true) {
                         cout << "Table options: 0 to keep current, or enter a specific table number (1-10):\n";
-                        ReservationManager::getInstance().viewTableAvailability();
+                        showTablesForUpdate(reservationId, newDate, newTime);
                         cout << "Choice: ";
                         getline(cin, newTableChoiceInput);
                         if (!validateNumericInput(newTableChoiceInput, newTableChoice, 0, 10)) {
@@ -1203,8 +6334,8 @@ public:
                     break;
                 }
                 case 5: {
-                    vector<Reservation> allReservations = ReservationManager::getInstance().getAllReservations();
-                    if (allReservations.empty()) {
+                    if (refuseChangeOnFollower()) break;
+                    if (!ReservationManager::getInstance().hasStoredReservations()) {
                         cout << "No reservations.\n";
                         break;
                     }
@@ -1218,35 +6349,26 @@ public:
                             getline(cin, reservationId);
                             reservationId = toUpperCase(reservationId);
 
-                            if (!validateReservationId(reservationId)) {
+                            long long numericId;
+                            if (!parseReservationId(reservationId, numericId)) {
                                 throw ReservationException("Invalid reservation ID format. Use 'ID <number>A', e.g., ID 1A.");
                             }
-                            bool found = false;
-                            for (const auto& res : allReservations) {
-                                if (res.id == reservationId) {
-                                    customerName = res.customerName;
-                                    found = true;
-                                    break;
-                                }
-                            }
+                            unique_ptr<Reservation> found = ReservationManager::getInstance().getReservation(numericId);
                             if (!found) {
                                 throw ReservationException("Reservation ID not found.");
                             }
+                            const Reservation& res = *found;
+                            customerName = res.customerName;
 
                             cout << "\n--- Reservation to Cancel ---\n";
                             cout << "ID\t\tCustomer\tParty\tDate\t\tTime\tContact\t\tTable\n";
-                            for (const auto& res : allReservations) {
-                                if (res.id == reservationId) {
-                                    cout << res.id << "\t"
-                                         << res.customerName << "\t"
-                                         << res.partySize << "\t"
-                                         << res.date << "\t"
-                                         << res.time << "\t"
-                                         << res.phoneNumber << "\t"
-                                         << (res.tableNumber + 1) << endl;
-                                    break;
-                                }
-                            }
+                            cout << formatReservationId(res.id) << "\t"
+                                 << res.customerName << "\t"
+                                 << res.partySize << "\t"
+                                 << res.date << "\t"
+                                 << res.time << "\t"
+                                 << res.phoneNumber << "\t"
+                                 << (res.tableNumber + 1) << endl;
 
                             string confirm;
                             cout << "Confirm cancellation? (Y/N or Yes/No): ";
@@ -1290,7 +6412,109 @@ public:
                                                                          "Username: " + recUsername);
                     break;
                 }
-                case 7: {
+                case 7:
+                    ReservationManager::getInstance().viewStorageStatus();
+                    break;
+                case 8: {
+                    string customerName;
+                    cout << "Enter customer name (or press Enter for all): ";
+                    getline(cin, customerName);
+                    ReservationManager::getInstance().viewArchivedReservations(customerName);
+                    break;
+                }
+                case 9: {
+                    if (refuseChangeOnFollower()) break;
+                    string path;
+                    cout << "Enter CSV file path (customer,phone,party,date,time,table): ";
+                    getline(cin, path);
+                    try {
+                        ofstream errors(IMPORT_ERRORS_FILE, ios::trunc);
+                        ImportStats stats = importReservationsCsv(path, "Admin", username, errors);
+                        printImportSummary(stats);
+                        if (stats.rejected > 0) {
+                            cout << "Rejected rows are listed in " << IMPORT_ERRORS_FILE << ".\n";
+                        }
+                    } catch (const ReservationException& ex) {
+                        cout << "Error: " << ex.what() << endl;
+                        ReservationManager::getInstance().logError("Admin", username, "Failed to import reservations",
+                                                                 ex.what());
+                    }
+                    break;
+                }
+                case 10: {
+                    string formatName, path;
+                    ExportFormat format;
+                    ExportFilter filter;
+                    while (true) {
+                        cout << "Enter format (csv or jsonl): ";
+                        getline(cin, formatName);
+                        if (parseExportFormat(formatName, format)) break;
+                        cout << "Invalid format. Please enter csv or jsonl.\n";
+                    }
+                    while (true) {
+                        cout << "Enter start date (YYYY-MM-DD, or press Enter for no limit): ";
+                        getline(cin, filter.fromDate);
+                        if (filter.fromDate.empty() || isDateShaped(filter.fromDate)) break;
+                        cout << "Invalid date format. Use YYYY-MM-DD.\n";
+                    }
+                    while (true) {
+                        cout << "Enter end date (YYYY-MM-DD, or press Enter for no limit): ";
+                        getline(cin, filter.toDate);
+                        if (filter.toDate.empty() || isDateShaped(filter.toDate)) break;
+                        cout << "Invalid date format. Use YYYY-MM-DD.\n";
+                    }
+                    cout << "Enter customer name (or press Enter for all): ";
+                    getline(cin, filter.customerName);
+                    cout << "Enter output file path (or press Enter to print here): ";
+                    getline(cin, path);
+                    try {
+                        size_t rows = exportReservationsTo(path, format, filter);
+                        cout << "Exported " << rows << " reservations" << (path.empty() ? "" : " to " + path) << ".\n";
+                        ReservationManager::getInstance().logReservationAction("Admin", username, "Exported reservations",
+                                                                             to_string(rows) + " rows to " +
+                                                                                 (path.empty() ? "screen" : path));
+                    } catch (const ReservationException& ex) {
+                        cout << "Error: " << ex.what() << endl;
+                        ReservationManager::getInstance().logError("Admin", username, "Failed to export reservations",
+                                                                 ex.what());
+                    }
+                    break;
+                }
+                case 11: {
+                    if (refuseChangeOnFollower()) break;
+                    string path;
+                    cout << "Enter backup directory (must be new or empty): ";
+                    getline(cin, path);
+                    try {
+                        ReservationManager::getInstance().startBackup(path);
+                        cout << "Backup started in the background. View Storage Status to follow it.\n";
+                        ReservationManager::getInstance().logReservationAction("Admin", username, "Started backup",
+                                                                             "Directory: " + path);
+                    } catch (const ReservationException& ex) {
+                        cout << "Error: " << ex.what() << endl;
+                        ReservationManager::getInstance().logError("Admin", username, "Failed to start backup",
+                                                                 ex.what());
+                    }
+                    break;
+                }
+                case 12: {
+                    string fromDate, toDate;
+                    while (true) {
+                        cout << "Enter start date (YYYY-MM-DD, or press Enter for no limit): ";
+                        getline(cin, fromDate);
+                        if (fromDate.empty() || isDateShaped(fromDate)) break;
+                        cout << "Invalid date format. Use YYYY-MM-DD.\n";
+                    }
+                    while (true) {
+                        cout << "Enter end date (YYYY-MM-DD, or press Enter for no limit): ";
+                        getline(cin, toDate);
+                        if (toDate.empty() || isDateShaped(toDate)) break;
+                        cout << "Invalid date format. Use YYYY-MM-DD.\n";
+                    }
+                    ReservationManager::getInstance().viewReservationReport(fromDate, toDate);
+                    break;
+                }
+                case 13: {
                     string logout;
                     cout << "Logout? (Y/N or Yes/No): ";
                     getline(cin, logout);
@@ -1305,12 +6529,1077 @@ public:
     }
 };
 
+// -------- Benchmarks --------
+// Run with: "reservation system" --bench <name> [rows]
+// Each benchmark works inside its own temporary directory, so the data files in
+// the current directory are never touched.
+class BenchmarkDirectory {
+    filesystem::path previous;
+    filesystem::path path;
+public:
+    BenchmarkDirectory() : previous(filesystem::current_path()) {
+        path = filesystem::temp_directory_path() /
+               ("reservation-bench-" + to_string(chrono::steady_clock::now().time_since_epoch().count()));
+        filesystem::create_directories(path);
+        filesystem::current_path(path);
+    }
+    ~BenchmarkDirectory() {
+        error_code ec;
+        filesystem::current_path(previous, ec);
+        filesystem::remove_all(path, ec);
+    }
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Deterministic sample reservation, spread over many customers, days and tables.
+Reservation makeBenchmarkReservation(size_t i) {
+    char phone[16], date[16], time[8];
+    snprintf(phone, sizeof(phone), "555-%03zu-%04zu", i % 1000, i % 10000);
+    snprintf(date, sizeof(date), "2025-%02zu-%02zu", 6 + i / 28 % 6, 1 + i % 28);
+    snprintf(time, sizeof(time), "%02zu:%02zu", 11 + i % 11, i % 4 * 15);
+    return Reservation(static_cast<long long>(i + 1), "Customer" + to_string(i % 5000), phone,
+                       static_cast<int>(1 + i % 8), date, time, static_cast<int>(i % 10));
+}
+
+void reportThroughput(const string& label, size_t rows, size_t bytes, double seconds) {
+    cout << label << ": " << seconds << " s, " << (bytes / 1048576.0) / seconds << " MB/s, "
+         << static_cast<long long>(rows / seconds) << " rows/s\n";
+}
+
+int runLegacyLoadBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream file("reservations.txt");
+        for (size_t i = 0; i < rows; ++i) {
+            file << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+        }
+    }
+    size_t bytes = static_cast<size_t>(filesystem::file_size("reservations.txt"));
+    cout << "legacy-load: " << rows << " rows, " << bytes / 1048576.0 << " MB, " << workerCount() << " workers\n";
+
+    // Baseline: the getline/stringstream loop loadReservations used before.
+    auto start = chrono::steady_clock::now();
+    vector<Reservation> baseline;
+    {
+        ifstream resFile("reservations.txt");
+        string line;
+        while (getline(resFile, line)) {
+            stringstream ss(line);
+            string id, customerName, phoneNumber, date, time;
+            int partySize, tableNumber;
+            getline(ss, id, '|');
+            getline(ss, customerName, '|');
+            getline(ss, phoneNumber, '|');
+            ss >> partySize;
+            ss.ignore(1);
+            getline(ss, date, '|');
+            getline(ss, time, '|');
+            ss >> tableNumber;
+            baseline.emplace_back(parseReservationIdOrInvalid(id), customerName, phoneNumber, partySize, date, time, tableNumber);
+        }
+    }
+    reportThroughput("  stringstream", baseline.size(), bytes, secondsSince(start));
+
+    start = chrono::steady_clock::now();
+    MappedFile mapped("reservations.txt");
+    vector<Reservation> parsed = parseLegacyReservations(mapped.data(), mapped.size());
+    reportThroughput("  parallel mmap", parsed.size(), bytes, secondsSince(start));
+
+    if (parsed.size() != baseline.size()) {
+        cout << "  MISMATCH: " << parsed.size() << " vs " << baseline.size() << " rows\n";
+        return 1;
+    }
+    return 0;
+}
+
+// A burst of clients appending journal records at once, once per durability mode.
+int runDurabilityBenchmark(size_t ops) {
+    const size_t threadCount = 64;
+    const pair<const char*, DurabilityMode> modes[] = {{"sync-every-op", DurabilityMode::SyncEveryOp},
+                                                       {"group-commit", DurabilityMode::GroupCommit},
+                                                       {"async", DurabilityMode::Async}};
+    cout << "durability: " << ops << " appends from " << threadCount << " threads\n";
+    for (const auto& mode : modes) {
+        BenchmarkDirectory dir;
+        auto start = chrono::steady_clock::now();
+        uint64_t flushes;
+        {
+            PersistenceQueue writer(mode.second, storageConfig.groupCommitMillis, storageConfig.groupCommitOps,
+                                    storageConfig.persistenceQueueCapacity);
+            writer.open(PersistedFile::Journal, JOURNAL_FILE);
+            vector<thread> clients;
+            for (size_t t = 0; t < threadCount; ++t) {
+                clients.emplace_back([&writer, ops, threadCount, t] {
+                    for (size_t i = t; i < ops; i += threadCount) {
+                        writer.waitDurable(writer.append(PersistedFile::Journal, journalLine(to_string(i + 1) + "|R|" +
+                                                         formatReservationFields(makeBenchmarkReservation(i)))));
+                    }
+                });
+            }
+            for (auto& client : clients) {
+                client.join();
+            }
+            flushes = writer.stats().flushes;
+        }
+        double seconds = secondsSince(start);
+        cout << "  " << mode.first << ": " << static_cast<long long>(ops / seconds) << " ops/s, "
+             << flushes << " fsyncs before shutdown\n";
+    }
+    return 0;
+}
+
+// A journal full of churn (every other reservation cancelled, every fourth one
+// updated) compacted into segments.
+int runCompactionBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream journal(JOURNAL_FILE);
+        long long lsn = 1;
+        for (size_t i = 0; i < rows; ++i) {
+            journal << journalLine(to_string(lsn++) + "|R|" + formatReservationFields(makeBenchmarkReservation(i)));
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            Reservation res = makeBenchmarkReservation(i);
+            if (i % 2 == 1) {
+                journal << journalLine(to_string(lsn++) + "|C|" + formatReservationId(res.id));
+            } else if (i % 4 == 0) {
+                res.partySize++;
+                journal << journalLine(to_string(lsn++) + "|U|" + formatReservationId(res.id) + "|" + formatReservationFields(res));
+            }
+        }
+    }
+    cout << "compaction: " << rows << " reservations, journal " << fileBytes(JOURNAL_FILE) / 1048576.0 << " MB, limit "
+         << storageConfig.compactionBytesPerSecond / 1048576.0 << " MB/s\n";
+
+    auto start = chrono::steady_clock::now();
+    ReservationManager& manager = ReservationManager::getInstance();
+    cout << "  replay: " << secondsSince(start) << " s\n";
+    CompactionStats stats = manager.compactNow();
+    cout << "  compaction: " << stats.lastMillis << " ms, " << stats.foldedRecords << " records folded, "
+         << stats.droppedTombstones << " tombstones dropped, " << stats.bytesWritten / 1048576.0 << " MB written\n"
+         << "  space amplification: " << stats.amplificationBefore << "x -> " << stats.amplificationAfter << "x\n";
+    return 0;
+}
+
+// Crash recovery over a large journal with a torn last record: CRC32C throughput,
+// then the verifying scan that finds where to truncate. Records are parsed but not
+// applied, so this measures the scan rather than the in-memory replay.
+int runRecoveryBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream journal(JOURNAL_FILE, ios::binary);
+        for (size_t i = 0; i < rows; ++i) {
+            journal << journalLine(to_string(i + 1) + "|R|" + formatReservationFields(makeBenchmarkReservation(i)));
+        }
+        string torn = journalLine(to_string(rows + 1) + "|C|ID 1A");
+        journal << torn.substr(0, torn.size() / 2);
+    }
+    MappedFile mapped(JOURNAL_FILE);
+    size_t bytes = mapped.size();
+    cout << "recovery: " << rows << " records, " << bytes / 1073741824.0 << " GB journal\n";
+
+    auto start = chrono::steady_clock::now();
+    uint32_t softwareCrc = crc32cSoftware(0, mapped.data(), bytes);
+    reportThroughput("  crc32c software", rows, bytes, secondsSince(start));
+    if (crc32cHardwareAvailable()) {
+        start = chrono::steady_clock::now();
+        uint32_t hardwareCrc = crc32cHardware(0, mapped.data(), bytes);
+        reportThroughput("  crc32c hardware", rows, bytes, secondsSince(start));
+        if (hardwareCrc != softwareCrc) {
+            cout << "  MISMATCH: hardware and software CRC32C differ\n";
+            return 1;
+        }
+    }
+
+    start = chrono::steady_clock::now();
+    size_t records = 0;
+    size_t intact = scanJournal(mapped.data(), bytes, [&records](string_view payload) {
+        string_view fields[9];
+        long long lsn;
+        int partySize, tableNumber;
+        if (!splitFieldViews(payload, '|', fields, 9) || !parseInteger(fields[0], lsn) ||
+            !parseInteger(fields[5], partySize) || !parseInteger(fields[8], tableNumber)) {
+            return false;
+        }
+        records++;
+        return true;
+    });
+    reportThroughput("  recovery scan", records, intact, secondsSince(start));
+    cout << "  truncate at byte " << intact << " (" << bytes - intact << " torn bytes)\n";
+    return records == rows && intact < bytes ? 0 : 1;
+}
+
+// Startup load of a large account log, then signup latency on top of it.
+int runAccountsBenchmark(size_t accounts) {
+    BenchmarkDirectory dir;
+    {
+        ofstream file("customer_accounts.txt", ios::binary);
+        for (size_t i = 0; i < accounts; ++i) {
+            file << journalLine("customer" + to_string(i) + "|password" + to_string(i * 7919 % 100000));
+        }
+    }
+    cout << "accounts: " << accounts << " accounts, " << fileBytes("customer_accounts.txt") / 1048576.0 << " MB\n";
+
+    CustomerAccountStore store("customer_accounts.txt");
+    auto start = chrono::steady_clock::now();
+    store.load();
+    cout << "  load: " << secondsSince(start) << " s\n";
+
+    const size_t signups = 1000;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < signups; ++i) {
+        store.add("newcustomer" + to_string(i), "secret");
+    }
+    cout << "  signup: " << secondsSince(start) / signups * 1e6 << " us each (fsynced)\n";
+    return store.size() == accounts + signups ? 0 : 1;
+}
+
+// Size of the columnar archive against the text and snapshot formats, and the
+// speed of a full sequential decode.
+int runArchiveBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    vector<Reservation> records;
+    records.reserve(rows);
+    size_t textBytes = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        records.push_back(makeBenchmarkReservation(i));
+        textBytes += formatReservationFields(records.back()).size() + 1;
+    }
+    writeBinarySnapshot("snapshot.bin", records, 0);
+    auto start = chrono::steady_clock::now();
+    writeArchiveFile("archive.arc", records, 0);
+    double encodeSeconds = secondsSince(start);
+    long long snapshotBytes = fileBytes("snapshot.bin"), archiveBytes = fileBytes("archive.arc");
+    cout << "archive: " << rows << " reservations\n"
+         << "  text: " << textBytes / 1048576.0 << " MB, snapshot: " << snapshotBytes / 1048576.0
+         << " MB, archive: " << archiveBytes / 1048576.0 << " MB\n"
+         << "  compression ratio: " << static_cast<double>(textBytes) / archiveBytes << "x vs text, "
+         << static_cast<double>(snapshotBytes) / archiveBytes << "x vs snapshot\n"
+         << "  encode: " << encodeSeconds << " s\n";
+
+    MappedFile mapped("archive.arc");
+    ArchiveView view(mapped);
+    start = chrono::steady_clock::now();
+    view.verify();
+    long long partyTotal = 0;
+    size_t decoded = 0;
+    view.forEach([&](const ArchivedReservation& record) {
+        partyTotal += record.partySize + record.tableNumber + record.id;
+        decoded++;
+    });
+    double seconds = secondsSince(start);
+    cout << "  decode: " << seconds << " s, " << textBytes / 1073741824.0 / seconds << " GB/s of text, "
+         << archiveBytes / 1073741824.0 / seconds << " GB/s of archive, " << static_cast<long long>(decoded / seconds)
+         << " rows/s\n";
+
+    long long expectedTotal = 0;
+    for (const auto& res : records) {
+        expectedTotal += res.partySize + res.tableNumber + res.id;
+    }
+    if (decoded != rows || partyTotal != expectedTotal) {
+        cout << "  MISMATCH: decoded data differs from the input\n";
+        return 1;
+    }
+
+    // The ID check an admin rename makes, with the file as a month of the store's archive.
+    filesystem::create_directories(ARCHIVE_DIR);
+    filesystem::rename("archive.arc", archivePath("2025-01"));
+    ReservationManager& manager = ReservationManager::getInstance();
+    start = chrono::steady_clock::now();
+    bool found = manager.reservationIdExists(1);
+    cout << "  id check: first " << secondsSince(start) * 1e3 << " ms";
+    const size_t checks = 1000;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < checks; ++i) {
+        found = manager.reservationIdExists(static_cast<long long>(i * 7919 % rows + 1)) && found;
+        found = !manager.reservationIdExists(static_cast<long long>(rows + 1 + i)) && found;
+    }
+    cout << ", then " << secondsSince(start) / (2 * checks) * 1e6 << " us per hit or miss\n";
+    ReservationManager::resetInstance();
+    return found ? 0 : 1;
+}
+
+// Peak resident set size in MB, or 0 where the platform does not report it.
+double peakMemoryMB() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1048576.0;
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// Migration of a legacy text store: reservations.txt, next_id.txt and a
+// header-less customer_accounts.txt with one account per ten reservations.
+int runMigrationBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream reservations("reservations.txt", ios::binary);
+        ofstream accounts("customer_accounts.txt", ios::binary);
+        for (size_t i = 0; i < rows; ++i) {
+            reservations << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+            if (i % 10 == 0) accounts << "customer" << i << "|password" << i % 100000 << "\n";
+        }
+        ofstream("next_id.txt") << rows + 1 << "\n";
+    }
+    long long bytes = fileBytes("reservations.txt") + fileBytes("customer_accounts.txt");
+    double memoryBefore = peakMemoryMB();
+    cout << "migrate: " << rows << " reservations, " << bytes / 1048576.0 << " MB of legacy files\n";
+
+    MigrationStats stats;
+    auto start = chrono::steady_clock::now();
+    bool migrated = migrateLegacyReservations(stats) && migrateLegacyAccounts("customer_accounts.txt", stats);
+    double seconds = secondsSince(start);
+    reportThroughput("  migration", stats.reservations, static_cast<size_t>(stats.bytesRead), seconds);
+    cout << "  " << stats.segments << " segments, " << stats.accounts << " accounts, peak memory "
+         << peakMemoryMB() << " MB (" << memoryBefore << " MB before)\n";
+    return migrated && stats.reservations == rows ? 0 : 1;
+}
+
+// A CSV of fresh bookings with a sprinkling of invalid rows and table conflicts,
+// validated on every worker and committed in batches.
+int runImportBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    size_t invalid = 0, duplicates = 0;
+    {
+        ofstream csv("import.csv", ios::binary);
+        csv << "customer,phone,party,date,time,table\n";
+        for (size_t i = 0; i < rows; ++i) {
+            // Every (date, time, table) slot is distinct until a row repeats the one before it.
+            size_t slot = i % 50 == 49 ? i - 1 : i;
+            char line[128];
+            snprintf(line, sizeof(line), "\"Guest, %zu\",555-%03zu-%04zu,%zu,%s,%02zu:%02zu,%zu\n", i % 5000, i % 1000,
+                     i % 10000, 1 + i % 8, addDays("2025-06-01", static_cast<int>(slot / 480)).c_str(),
+                     11 + slot / 10 % 48 / 4, slot / 10 % 4 * 15, 1 + slot % 10);
+            if (i % 1000 == 999) {
+                csv << "Bad Row,555-1234,0,2025-13-01,25:00,11\n";
+                invalid++;
+            } else {
+                csv << line;
+                duplicates += slot != i ? 1 : 0;
+            }
+        }
+    }
+    long long bytes = fileBytes("import.csv");
+    cout << "import: " << rows << " rows, " << bytes / 1048576.0 << " MB, " << workerCount() << " workers\n";
+
+    ostringstream errors;
+    ImportStats stats = importReservationsCsv("import.csv", "Admin", "benchmark", errors);
+    reportThroughput("  import", stats.rows, static_cast<size_t>(stats.bytes), stats.seconds);
+    cout << "  " << stats.imported << " imported, " << stats.rejected << " rejected (" << stats.conflicts
+         << " table conflicts)\n";
+    CompactionStats checkpoint = ReservationManager::getInstance().compactNow();
+    cout << "  checkpoint into segments: " << checkpoint.lastMillis << " ms\n";
+    return stats.rows == rows && stats.conflicts == duplicates && stats.rejected == invalid + duplicates ? 0 : 1;
+}
+
+// A store migrated into on-disk segments, exported whole and by date range.
+int runExportBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream reservations("reservations.txt", ios::binary);
+        for (size_t i = 0; i < rows; ++i) {
+            reservations << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+        }
+        ofstream("next_id.txt") << rows + 1 << "\n";
+    }
+    ReservationManager::getInstance();
+    double memoryBefore = peakMemoryMB();
+    cout << "export: " << rows << " reservations, peak memory after load " << memoryBefore << " MB\n";
+
+    const pair<const char*, ExportFormat> formats[] = {{"csv", ExportFormat::Csv},
+                                                       {"jsonl", ExportFormat::JsonLines}};
+    for (const auto& format : formats) {
+        const string path = string("export.") + format.first;
+        auto start = chrono::steady_clock::now();
+        size_t written = exportReservationsTo(path, format.second, ExportFilter());
+        reportThroughput(string("  ") + format.first, written, static_cast<size_t>(fileBytes(path)),
+                         secondsSince(start));
+        error_code ec;
+        filesystem::remove(path, ec);
+        if (written != rows) return 1;
+    }
+    ExportFilter week;
+    week.fromDate = "2025-07-01";
+    week.toDate = "2025-07-07";
+    auto start = chrono::steady_clock::now();
+    size_t written = exportReservationsTo("export.week.csv", ExportFormat::Csv, week);
+    cout << "  one week (" << week.fromDate << " to " << week.toDate << "): " << written << " rows in "
+         << secondsSince(start) << " s\n";
+    cout << "  peak memory " << peakMemoryMB() << " MB (" << memoryBefore << " MB before exporting)\n";
+    return 0;
+}
+
+// Point-in-time restore from an empty checkpoint over a journal of reservations,
+// updates and cancellations (every other reservation cancelled, every fourth updated).
+int runRestoreBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    filesystem::create_directories(checkpointHistoryPath(0) + "/" + ARCHIVE_DIR);
+    writeFileAtomically(checkpointHistoryPath(0) + "/manifest.txt", manifestHeader(0, 1));
+    writeFileAtomically(checkpointHistoryPath(0) + "/checkpoint.txt", "0|0\n");
+    long long lsn = 1;
+    {
+        ofstream journal(JOURNAL_FILE, ios::binary);
+        journal << journalLine(formatHeader(JOURNAL_TAG, JOURNAL_FORMAT_VERSION));
+        journal << journalLine(to_string(lsn++) + "|T|" + to_string(wallClockMillis()));
+        for (size_t i = 0; i < rows; ++i) {
+            journal << journalLine(to_string(lsn++) + "|R|" + formatReservationFields(makeBenchmarkReservation(i)));
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            Reservation res = makeBenchmarkReservation(i);
+            if (i % 2 == 1) {
+                journal << journalLine(to_string(lsn++) + "|C|" + formatReservationId(res.id));
+            } else if (i % 4 == 0) {
+                res.partySize++;
+                journal << journalLine(to_string(lsn++) + "|U|" + formatReservationId(res.id) + "|" + formatReservationFields(res));
+            }
+        }
+    }
+    cout << "restore: " << lsn - 1 << " journal records, " << fileBytes(JOURNAL_FILE) / 1048576.0 << " MB\n";
+
+    RestoreTarget target;
+    target.lsn = lsn - 1;
+    double memoryBefore = peakMemoryMB();
+    RestoreStats stats = restoreToPointInTime(target, "restored");
+    cout << "  replay: " << stats.replayedRecords << " records in " << stats.replaySeconds << " s, "
+         << static_cast<long long>(stats.replayedRecords / max(stats.replaySeconds, 1e-9)) << " records/s\n"
+         << "  restore: " << stats.seconds << " s in total, " << stats.rewrittenSegments << " segments written, peak RSS "
+         << memoryBefore << " MB before, " << peakMemoryMB() << " MB after\n";
+
+    size_t restored = 0;
+    ifstream manifest("restored/" + MANIFEST_FILE);
+    string line;
+    while (getline(manifest, line)) {
+        vector<string> fields = splitFields(line, '|');
+        if (fields.size() == 3) restored += stoull(fields[1]);
+    }
+    return restored == rows - rows / 2 ? 0 : 1;
+}
+
+// samples is sorted in place.
+double percentile(vector<double>& samples, double fraction) {
+    if (samples.empty()) return 0;
+    sort(samples.begin(), samples.end());
+    return samples[min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()))];
+}
+
+// Write latency with and without a backup of a migrated store running alongside.
+// Writes are paced so both phases see the same offered load.
+int runBackupBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    {
+        ofstream reservations("reservations.txt", ios::binary);
+        for (size_t i = 0; i < rows; ++i) {
+            reservations << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+        }
+    }
+    ReservationManager& manager = ReservationManager::getInstance();
+    manager.compactNow();
+    cout << "backup: " << rows << " reservations, " << durabilityModeName(storageConfig.durability)
+         << " durability, copy limit " << storageConfig.compactionBytesPerSecond / 1048576.0 << " MB/s\n";
+
+    size_t written = 0;
+    auto writeOnce = [&]() {
+        // A fresh (date, time, table) slot per write, after every benchmark reservation.
+        vector<ImportRow> batch(1);
+        char time[8];
+        snprintf(time, sizeof(time), "%02zu:%02zu", 11 + written / 10 % 40 / 4, written / 10 % 4 * 15);
+        batch[0].res = Reservation(0, "Walk-in", "555-000-0000", 2, addDays("2026-01-01", static_cast<int>(written / 400)),
+                                   time, static_cast<int>(written % 10));
+        auto start = chrono::steady_clock::now();
+        manager.commitImportBatch(batch);
+        written++;
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    };
+    auto report = [](const string& label, vector<double>& samples) {
+        double p50 = percentile(samples, 0.50), p99 = percentile(samples, 0.99);
+        cout << "  " << label << ": " << samples.size() << " writes, p50 " << p50 << " us, p99 " << p99
+             << " us, max " << samples.back() << " us\n";
+    };
+    const size_t minimumWrites = 20000;
+    const auto pace = chrono::microseconds(100);
+
+    vector<double> idle;
+    for (size_t i = 0; i < minimumWrites; ++i) {
+        idle.push_back(writeOnce());
+        this_thread::sleep_for(pace);
+    }
+    report("no backup", idle);
+
+    vector<double> during;
+    double compactionSeconds = -1;
+    manager.startBackup("backup");
+    while (manager.backupStatus().running || during.size() < minimumWrites) {
+        during.push_back(writeOnce());
+        this_thread::sleep_for(pace);
+        if (during.size() == minimumWrites / 2 && manager.backupStatus().running) {
+            // A checkpoint must not have to wait for the copy to finish.
+            auto start = chrono::steady_clock::now();
+            manager.compactNow();
+            compactionSeconds = secondsSince(start);
+        }
+    }
+    BackupStatus backup = manager.waitForBackup();
+    report("during backup", during);
+    cout << "  backup: LSN " << backup.lsn << ", " << backup.files << " files, " << backup.bytesCopied / 1048576.0
+         << " MB in " << backup.seconds << " s" << (backup.succeeded ? "" : ", FAILED: " + backup.error) << "\n";
+    if (compactionSeconds >= 0) {
+        cout << "  compaction during backup: " << compactionSeconds << " s\n";
+    }
+    return backup.succeeded ? 0 : 1;
+}
+
+// A follower catching up on a journal of `rows` reservations, then the delay
+// before each single record appended afterwards becomes visible to it. This
+// process plays the primary by appending journal lines directly.
+int runFollowerBenchmark(size_t rows) {
+    BenchmarkDirectory dir;
+    ofstream journal(JOURNAL_FILE, ios::binary);
+    long long lsn = 1;
+    journal << journalLine(formatHeader(JOURNAL_TAG, JOURNAL_FORMAT_VERSION));
+    for (size_t i = 0; i < rows; ++i) {
+        journal << journalLine(to_string(lsn++) + "|R|" + formatReservationFields(makeBenchmarkReservation(i)));
+    }
+    journal.flush();
+    cout << "follower: " << rows << " journal records, " << fileBytes(JOURNAL_FILE) / 1048576.0 << " MB, polling every "
+         << storageConfig.followerPollMillis << " ms\n";
+
+    storageConfig.follower = true;
+    auto start = chrono::steady_clock::now();
+    ReservationManager& follower = ReservationManager::getInstance();
+    reportThroughput("catch-up", rows, static_cast<size_t>(fileBytes(JOURNAL_FILE)), secondsSince(start));
+
+    const size_t samples = 200;
+    vector<double> visible;
+    for (size_t i = 0; i < samples; ++i) {
+        // Spread the writes across the poll interval instead of always just after a poll.
+        this_thread::sleep_for(chrono::milliseconds(static_cast<int>(i) % storageConfig.followerPollMillis));
+        Reservation res = makeBenchmarkReservation(rows + i);
+        journal << journalLine(to_string(lsn) + "|R|" + formatReservationFields(res));
+        journal.flush();
+        auto written = chrono::steady_clock::now();
+        while (follower.followerStatus().appliedLsn < lsn) {
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+        visible.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - written).count());
+        lsn++;
+    }
+    double p50 = percentile(visible, 0.50), p99 = percentile(visible, 0.99);
+    cout << "  visibility: " << samples << " single writes, p50 " << p50 << " ms, p99 " << p99 << " ms, max "
+         << visible.back() << " ms\n";
+    return follower.getAllReservations().size() == rows + samples ? 0 : 1;
+}
+
+// The same workload against every backend built in: `rows` single-reservation
+// writes, cancelling every other one, then a restart. Latencies are per operation.
+int runBackendsBenchmark(size_t rows) {
+    cout << "backends: " << rows << " writes, " << rows / 2 << " cancels, "
+         << durabilityModeName(storageConfig.durability) << " durability\n";
+    int status = 0;
+    for (StorageBackend backend : availableStorageBackends()) {
+        BenchmarkDirectory dir;
+        storageConfig.backend = backend;
+        ReservationManager& manager = ReservationManager::getInstance();
+        vector<double> writes, cancels;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < rows; ++i) {
+            vector<ImportRow> batch(1);
+            batch[0].res = makeBenchmarkReservation(i);
+            auto opStart = chrono::steady_clock::now();
+            manager.commitImportBatch(batch);
+            writes.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - opStart).count());
+        }
+        double writeSeconds = secondsSince(start);
+        for (size_t i = 1; i < rows; i += 2) {
+            auto opStart = chrono::steady_clock::now();
+            manager.cancelReservation("ID " + to_string(i + 1) + "A", "");
+            cancels.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - opStart).count());
+        }
+        ReservationManager::resetInstance();
+
+        start = chrono::steady_clock::now();
+        size_t loaded = ReservationManager::getInstance().getAllReservations().size();
+        double startupMillis = secondsSince(start) * 1000;
+        ReservationManager::resetInstance();
+        long long bytes = 0;
+        for (filesystem::recursive_directory_iterator it("."), end; it != end; ++it) {
+            if (it->is_regular_file() && it->path().filename() != "logs.txt") bytes += fileBytes(it->path().string());
+        }
+
+        double writeP50 = percentile(writes, 0.50), writeP99 = percentile(writes, 0.99);
+        double cancelP50 = percentile(cancels, 0.50), cancelP99 = percentile(cancels, 0.99);
+        cout << "  " << storageBackendName(backend) << ": " << static_cast<long long>(rows / writeSeconds)
+             << " writes/s, write p50 " << writeP50 << " us p99 " << writeP99 << " us, cancel p50 " << cancelP50
+             << " us p99 " << cancelP99 << " us, startup " << startupMillis << " ms, " << bytes / 1024 << " KB"
+             << "\n";
+        size_t expected = backend == StorageBackend::Memory ? 0 : rows - rows / 2;
+        if (loaded != expected) {
+            cout << "    expected " << expected << " reservations after restart, found " << loaded << "\n";
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// Cancel, update and unknown-ID latency from 1K reservations up to maxRows in
+// tenfold steps. Targets are spread evenly over the store, so a linear lookup would
+// pay for half of it on average, and a miss for all of it.
+int runIdIndexBenchmark(size_t maxRows) {
+    const int defaultWindow = storageConfig.activeWindowDays;
+    const size_t samples = 500;
+    cout << "id-index: " << samples << " cancels, updates and misses per store size\n";
+    for (size_t rows = 1000; rows <= maxRows; rows *= 10) {
+        // First with every segment resident, then with the configured active window,
+        // which leaves nearly every benchmark date in an unloaded segment.
+        for (int window : {36500, defaultWindow}) {
+            storageConfig.activeWindowDays = window;
+            BenchmarkDirectory dir;
+            {
+                ofstream reservations("reservations.txt", ios::binary);
+                for (size_t i = 0; i < rows; ++i) {
+                    reservations << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+                }
+            }
+            auto start = chrono::steady_clock::now();
+            ReservationManager& manager = ReservationManager::getInstance();
+            double loadSeconds = secondsSince(start);
+            auto missOnce = [&manager](size_t id) {
+                auto opStart = chrono::steady_clock::now();
+                try {
+                    manager.cancelReservation("ID " + to_string(id) + "A", "Bench");
+                } catch (const ReservationException&) {
+                }
+                return chrono::duration<double, micro>(chrono::steady_clock::now() - opStart).count();
+            };
+            double firstMiss = missOnce(rows * 10);  // lists the unloaded segments' IDs once
+            vector<double> cancels, updates, misses;
+            size_t stride = rows / samples;
+            for (size_t s = 0; s < samples; ++s) {
+                auto opStart = chrono::steady_clock::now();
+                manager.cancelReservation("ID " + to_string(s * stride + 1) + "A", "Bench");
+                cancels.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - opStart).count());
+                opStart = chrono::steady_clock::now();
+                manager.updateReservation("ID " + to_string(s * stride + 2) + "A", "Bench", "0", "0", "0",
+                                          static_cast<int>(1 + s % 8), "0", "0", -1);
+                updates.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - opStart).count());
+                misses.push_back(missOnce(rows * 10 + s + 1));
+            }
+            ReservationManager::resetInstance();
+            cout << "  " << rows << " reservations, " << (window == 36500 ? "all resident" : "default window")
+                 << " (loaded in " << loadSeconds << " s, first miss " << firstMiss << " us): cancel p50 "
+                 << percentile(cancels, 0.50) << " us p99 " << percentile(cancels, 0.99) << " us, update p50 "
+                 << percentile(updates, 0.50) << " us p99 " << percentile(updates, 0.99) << " us, miss p50 "
+                 << percentile(misses, 0.50) << " us p99 " << percentile(misses, 0.99) << " us\n";
+        }
+    }
+    storageConfig.activeWindowDays = defaultWindow;
+    return 0;
+}
+
+// "View My Reservations" and hasReservations for sampled customers who hold eight
+// bookings each, as the store grows. Segments outside the active window stay on
+// disk, so the views read both resident reservations and unloaded segments.
+int runCustomerIndexBenchmark(size_t maxRows) {
+    const size_t samples = 500, bookingsEach = 8;
+    cout << "customers: " << samples << " views per store size, " << bookingsEach << " bookings per customer\n";
+    for (size_t rows = 10000; rows <= maxRows; rows *= 10) {
+        BenchmarkDirectory dir;
+        size_t customers = rows / bookingsEach;
+        {
+            ofstream reservations("reservations.txt", ios::binary);
+            for (size_t i = 0; i < rows; ++i) {
+                Reservation res = makeBenchmarkReservation(i);
+                res.customerName = "Customer" + to_string(i % customers);
+                reservations << formatReservationFields(res) << "\n";
+            }
+        }
+        ReservationManager& manager = ReservationManager::getInstance();
+        streambuf* console = cout.rdbuf(nullptr);
+        auto start = chrono::steady_clock::now();
+        manager.viewCustomerReservations("Customer0");
+        double firstView = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        vector<double> views, checks;
+        for (size_t s = 0; s < samples; ++s) {
+            string name = "Customer" + to_string(s * (customers / samples));
+            start = chrono::steady_clock::now();
+            manager.viewCustomerReservations(name);
+            views.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            start = chrono::steady_clock::now();
+            bool found = manager.hasReservations(name);
+            checks.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            if (!found) {
+                cout.rdbuf(console);
+                cout << "customers: " << name << " has no reservations\n";
+                return 1;
+            }
+        }
+        cout.rdbuf(console);
+        cout.clear();
+        ReservationManager::resetInstance();
+        cout << "  " << rows << " reservations: first view " << firstView << " us, view p50 "
+             << percentile(views, 0.50) << " us p99 " << percentile(views, 0.99) << " us, hasReservations p50 "
+             << percentile(checks, 0.50) << " us p99 " << percentile(checks, 0.99) << " us\n";
+    }
+    return 0;
+}
+
+// findReservationsByPhone for sampled callers who hold four bookings each, against
+// the linear scan over every reservation that a phone lookup would otherwise be, and
+// the phone index's memory per million reservations. Every segment stays resident.
+int runPhoneIndexBenchmark(size_t maxRows) {
+    storageConfig.activeWindowDays = 36500;
+    const size_t samples = 1000, bookingsEach = 4;
+    cout << "phones: " << samples << " lookups per store size, " << bookingsEach << " bookings per phone\n";
+    for (size_t rows = 10000; rows <= maxRows; rows *= 10) {
+        BenchmarkDirectory dir;
+        size_t callers = rows / bookingsEach;
+        auto phoneOf = [](size_t caller) {
+            char phone[16];
+            snprintf(phone, sizeof(phone), "%03zu-%03zu-%04zu", 200 + caller / 10000000 % 800,
+                     caller / 10000 % 1000, caller % 10000);
+            return string(phone);
+        };
+        {
+            ofstream reservations("reservations.txt", ios::binary);
+            for (size_t i = 0; i < rows; ++i) {
+                Reservation res = makeBenchmarkReservation(i);
+                res.phoneNumber = phoneOf(i % callers);
+                reservations << formatReservationFields(res) << "\n";
+            }
+        }
+        ReservationManager& manager = ReservationManager::getInstance();
+        vector<double> lookups;
+        for (size_t s = 0; s < samples; ++s) {
+            string phone = phoneOf(s * (callers / samples));
+            auto start = chrono::steady_clock::now();
+            vector<Reservation> found = manager.findReservationsByPhone(phone);
+            lookups.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            if (found.size() != bookingsEach) {
+                cout << "phones: " << phone << " returned " << found.size() << " reservations\n";
+                return 1;
+            }
+        }
+        vector<Reservation> all = manager.getAllReservations();
+        vector<double> scans;
+        for (size_t s = 0; s < 20; ++s) {
+            string phone = phoneOf(s * (callers / 20));
+            auto start = chrono::steady_clock::now();
+            vector<Reservation> found;
+            for (const auto& res : all) {
+                if (res.phoneNumber == phone) found.push_back(res);
+            }
+            scans.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        }
+        double perMillion = manager.phoneIndexBytes() * (1000000.0 / rows) / (1024 * 1024);
+        ReservationManager::resetInstance();
+        cout << "  " << rows << " reservations: lookup p50 " << percentile(lookups, 0.50) << " us p99 "
+             << percentile(lookups, 0.99) << " us, scan p50 " << percentile(scans, 0.50) << " us, index "
+             << perMillion << " MB per million reservations\n";
+    }
+    return 0;
+}
+
+// One-week exports and day sheets against the scan over every reservation they used
+// to be, as the store grows, with a hundred bookings a day. Every segment stays
+// resident. A round of cancels and date changes first reshuffles the time index, and
+// each week is checked against the scan.
+int runTimeIndexBenchmark(size_t maxRows) {
+    storageConfig.activeWindowDays = 36500;
+    const size_t samples = 200, perDay = 100, churn = 1000;
+    cout << "dates: " << samples << " ranges per store size, " << perDay << " bookings a day\n";
+    for (size_t rows = 10000; rows <= maxRows; rows *= 10) {
+        BenchmarkDirectory dir;
+        size_t days = rows / perDay;
+        {
+            ofstream reservations("reservations.txt", ios::binary);
+            for (size_t i = 0; i < rows; ++i) {
+                Reservation res = makeBenchmarkReservation(i);
+                res.date = addDays("2026-01-01", static_cast<int>(i / perDay));
+                reservations << formatReservationFields(res) << "\n";
+            }
+        }
+        ReservationManager& manager = ReservationManager::getInstance();
+        streambuf* console = cout.rdbuf(nullptr);
+        for (size_t i = 0; i < churn; ++i) {
+            manager.cancelReservation("ID " + to_string(i * (rows / churn) + 1) + "A", "Bench");
+            manager.updateReservation("ID " + to_string(i * (rows / churn) + 2) + "A", "Bench", "0", "0", "0", 0,
+                                      addDays("2026-01-01", static_cast<int>(i * 7 % days)), "0", -1);
+        }
+        vector<Reservation> all = manager.getAllReservations();
+        ostream discard(nullptr);
+        vector<double> weeks, scans, sheets;
+        for (size_t s = 0; s < samples; ++s) {
+            ExportFilter week;
+            week.fromDate = addDays("2026-01-01", static_cast<int>(s * (days - 7) / samples));
+            week.toDate = addDays(week.fromDate, 6);
+            ExportWriter indexed(discard, ExportFormat::Csv);
+            auto start = chrono::steady_clock::now();
+            size_t found = manager.exportReservations(week, indexed);
+            weeks.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            ExportWriter scanned(discard, ExportFormat::Csv);
+            start = chrono::steady_clock::now();
+            for (const auto& res : all) {
+                if (week.matches(res)) scanned.write(res);
+            }
+            scanned.finish();
+            scans.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            if (found != scanned.rows()) {
+                cout.rdbuf(console);
+                cout << "dates: " << week.fromDate << " to " << week.toDate << " found " << found << ", scan "
+                     << scanned.rows() << "\n";
+                return 1;
+            }
+            start = chrono::steady_clock::now();
+            manager.viewDaySheet(week.fromDate);
+            sheets.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        }
+        cout.rdbuf(console);
+        cout.clear();
+        ReservationManager::resetInstance();
+
+        // Index upkeep on its own: inserts and erases at times spread over the store.
+        TimeIndex index;
+        index.rebuild(all);
+        const size_t changes = 10000;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < changes; ++i) {
+            index.insert(packReservationTime(all[i * 97 % all.size()].date, "18:00"), all.size() + i);
+        }
+        double insertNs = secondsSince(start) * 1e9 / changes;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < changes; ++i) {
+            index.erase(packReservationTime(all[i * 97 % all.size()].date, "18:00"), all.size() + i);
+        }
+        double eraseNs = secondsSince(start) * 1e9 / changes;
+        cout << "  " << rows << " reservations: week export p50 " << percentile(weeks, 0.50) << " us p99 "
+             << percentile(weeks, 0.99) << " us, scan p50 " << percentile(scans, 0.50) << " us, day sheet p50 "
+             << percentile(sheets, 0.50) << " us, index insert " << insertNs << " ns, erase " << eraseNs
+             << " ns, " << index.memoryBytes() / 1048576.0 << " MB\n";
+    }
+    return 0;
+}
+
+// Bytes of heap in use, or -1 where the C library cannot say.
+long long heapBytesInUse() {
+#ifdef RESERVATION_HEAP_STATS
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<long long>(info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// Heap per resident reservation, then the time per reserve, cancel and update on a
+// store of `rows` reservations, driven through the same entry points as the menus.
+int runIdBenchmark(size_t rows) {
+    storageConfig.activeWindowDays = 36500;  // every segment stays resident
+    BenchmarkDirectory dir;
+    {
+        ofstream reservations("reservations.txt", ios::binary);
+        for (size_t i = 0; i < rows; ++i) {
+            reservations << formatReservationFields(makeBenchmarkReservation(i)) << "\n";
+        }
+    }
+    long long heapBefore = heapBytesInUse();
+    ReservationManager& manager = ReservationManager::getInstance();
+    long long heapAfter = heapBytesInUse();
+    cout << "ids: " << rows << " reservations, sizeof(Reservation) " << sizeof(Reservation) << " bytes";
+    if (heapBefore >= 0) {
+        cout << ", " << (heapAfter - heapBefore) / static_cast<double>(rows) << " heap bytes each";
+    }
+    cout << "\n";
+
+    size_t ops = min<size_t>(100000, rows / 4);
+    auto report = [ops](const string& label, double seconds) {
+        cout << "  " << label << ": " << ops << " ops, " << seconds * 1e9 / ops << " ns/op\n";
+    };
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        // Fresh (date, time, table) slots after every benchmark reservation.
+        vector<ImportRow> batch(1);
+        batch[0].res = makeBenchmarkReservation(i);
+        batch[0].res.date = addDays("2026-01-01", static_cast<int>(i / 440));
+        manager.commitImportBatch(batch);
+    }
+    report("reserve", secondsSince(start));
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        manager.cancelReservation("ID " + to_string(i * 4 + 1) + "A", "Bench");
+    }
+    report("cancel", secondsSince(start));
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        manager.updateReservation("ID " + to_string(i * 4 + 2) + "A", "Bench", "0", "0", "0",
+                                  static_cast<int>(1 + i % 8), "0", "0", -1);
+    }
+    report("update", secondsSince(start));
+
+    // The ID work alone: what every operation did while IDs were strings (upper-case
+    // the input, upper-case it again to match the regex, hash it for the index)
+    // against parsing it once into an integer.
+    vector<string> inputs(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        inputs[i] = "id " + to_string(i * 4 + 1) + "a";
+    }
+    static const regex idRegex("ID \\d+A");
+    size_t checksum = 0;
+    start = chrono::steady_clock::now();
+    for (const auto& text : inputs) {
+        string upperId = toUpperCase(text);
+        if (regex_match(toUpperCase(upperId), idRegex)) checksum += hash<string>()(upperId);
+    }
+    report("id as string", secondsSince(start));
+    start = chrono::steady_clock::now();
+    for (const auto& text : inputs) {
+        long long id;
+        if (parseReservationId(text, id)) checksum += static_cast<size_t>(id);
+    }
+    report("id as integer", secondsSince(start));
+    ReservationManager::resetInstance();
+    return checksum == 0 ? 1 : 0;
+}
+
+int runBenchmark(int argc, char* argv[]) {
+    string name = argc > 2 ? argv[2] : "";
+    size_t rows = 0;
+    if (argc > 3) {
+        rows = static_cast<size_t>(strtoull(argv[3], nullptr, 10));
+    }
+    if (name == "legacy-load") return runLegacyLoadBenchmark(rows ? rows : 1000000);
+    if (name == "durability") return runDurabilityBenchmark(rows ? rows : 1000000);
+    if (name == "compaction") return runCompactionBenchmark(rows ? rows : 20000);
+    if (name == "recovery") return runRecoveryBenchmark(rows ? rows : 1000000);
+    if (name == "accounts") return runAccountsBenchmark(rows ? rows : 1000000);
+    if (name == "archive") return runArchiveBenchmark(rows ? rows : 1000000);
+    if (name == "migrate") return runMigrationBenchmark(rows ? rows : 10000000);
+    if (name == "import") return runImportBenchmark(rows ? rows : 1000000);
+    if (name == "export") return runExportBenchmark(rows ? rows : 10000000);
+    if (name == "restore") return runRestoreBenchmark(rows ? rows : 1000000);
+    if (name == "backup") return runBackupBenchmark(rows ? rows : 1000000);
+    if (name == "follower") return runFollowerBenchmark(rows ? rows : 1000000);
+    if (name == "backends") return runBackendsBenchmark(rows ? rows : 2000);
+    if (name == "id-index") return runIdIndexBenchmark(rows ? rows : 10000000);
+    if (name == "ids") return runIdBenchmark(rows ? rows : 1000000);
+    if (name == "customers") return runCustomerIndexBenchmark(rows ? rows : 1000000);
+    if (name == "phones") return runPhoneIndexBenchmark(rows ? rows : 1000000);
+    if (name == "dates") return runTimeIndexBenchmark(rows ? rows : 1000000);
+    cout << "Usage: --bench <name> [rows]\n"
+         << "Benchmarks: legacy-load, durability, compaction, recovery, accounts, archive, migrate, import, export,\n"
+         << "            restore, backup, follower, backends, id-index, ids, customers, phones, dates\n";
+    return 1;
+}
+
 // -------- Main Driver --------
-int main() {
+int main(int argc, char* argv[]) {
     const string adminUsername = "admin";
     const string adminPassword = "admin123";
 
-    loadCustomerAccounts(customerAccounts);
+    loadStorageConfig(storageConfig);
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        return runBenchmark(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--import") {
+        if (argc != 3) {
+            cout << "Usage: --import <file.csv>\n";
+            return 1;
+        }
+        try {
+            ImportStats stats = importReservationsCsv(argv[2], "Admin", "command line", cerr);
+            printImportSummary(stats);
+            return stats.rejected == 0 ? 0 : 2;
+        } catch (const ReservationException& ex) {
+            cerr << "Error: " << ex.what() << endl;
+            return 1;
+        }
+    }
+    if (argc > 1 && string(argv[1]) == "--restore-at") {
+        RestoreTarget target;
+        if ((argc != 3 && !(argc == 5 && string(argv[3]) == "--into")) || !parseRestoreTarget(argv[2], target)) {
+            cout << "Usage: --restore-at <lsn|\"YYYY-MM-DD HH:MM[:SS]\"> [--into DIR]\n";
+            return 1;
+        }
+        string intoDir = argc == 5 ? argv[4] : "restored";
+        try {
+            RestoreStats stats = restoreToPointInTime(target, intoDir);
+            cout << "Restored LSN " << stats.restoredLsn << " into " << intoDir << " from checkpoint " << stats.baseLsn
+                 << " (" << formatLocalTime(stats.baseMillis) << ").\n"
+                 << "Replayed " << stats.replayedRecords << " journal records in " << stats.replaySeconds << " s; "
+                 << stats.rewrittenSegments << " segments rewritten, " << stats.linkedSegments << " linked; "
+                 << stats.seconds << " s in total.\n"
+                 << "Customer accounts are not versioned: " << intoDir
+                 << "/customer_accounts.txt is a copy of the current file, not the accounts as of the restore point.\n"
+                 << "Stop the program before moving the restored files into place.\n";
+            return 0;
+        } catch (const exception& ex) {
+            cerr << "Error: " << ex.what() << endl;
+            return 1;
+        }
+    }
+    if (argc > 1 && string(argv[1]) == "--export") {
+        ExportFormat format;
+        ExportFilter filter;
+        string path;
+        bool valid = argc > 2 && parseExportFormat(argv[2], format);
+        for (int i = 3; valid && i + 1 < argc; i += 2) {
+            string option = argv[i];
+            if (option == "--from" && isDateShaped(argv[i + 1])) {
+                filter.fromDate = argv[i + 1];
+            } else if (option == "--to" && isDateShaped(argv[i + 1])) {
+                filter.toDate = argv[i + 1];
+            } else if (option == "--customer") {
+                filter.customerName = argv[i + 1];
+            } else if (option == "--output") {
+                path = argv[i + 1];
+            } else {
+                valid = false;
+            }
+        }
+        if (!valid || argc % 2 == 0) {
+            cout << "Usage: --export <csv|jsonl> [--from YYYY-MM-DD] [--to YYYY-MM-DD] [--customer NAME] "
+                    "[--output FILE]\n";
+            return 1;
+        }
+        try {
+            size_t rows = exportReservationsTo(path, format, filter);
+            cerr << "Exported " << rows << " reservations.\n";
+            return 0;
+        } catch (const ReservationException& ex) {
+            cerr << "Error: " << ex.what() << endl;
+            return 1;
+        }
+    }
+
+    if (argc > 1 && string(argv[1]) == "--follower") {
+        if (argc > 3) {
+            cout << "Usage: --follower [DIR]\n";
+            return 1;
+        }
+        error_code ec;
+        if (argc == 3) {
+            filesystem::current_path(argv[2], ec);
+        }
+        if (ec) {
+            cerr << "Error: Unable to open " << argv[2] << ": " << ec.message() << endl;
+            return 1;
+        }
+        if (storageConfig.backend != StorageBackend::Journal) {
+            cerr << "Error: Followers need the journal storage backend." << endl;
+            return 1;
+        }
+        storageConfig.follower = true;
+        cout << "Read-only follower of the store in " << filesystem::current_path().string()
+             << ". Changes must be made on the primary.\n";
+    }
+
+    customerAccounts.load(storageConfig.follower);
 
     bool isRunning = true;
     while (isRunning) {
@@ -1365,7 +7654,9 @@ int main() {
                     cout << "Invalid choice. Please enter a single number between 1 and 2.\n";
                 }
 
-                if (custOption == 1) {
+                if (custOption == 1 && refuseChangeOnFollower()) {
+                    break;
+                } else if (custOption == 1) {
                     user = unique_ptr<Customer>(new Customer(true));
                 } else if (custOption == 2) {
                     user = unique_ptr<Customer>(new Customer(false));